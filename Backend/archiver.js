@@ -0,0 +1,265 @@
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+const { withTransaction } = require('./db');
+const { lockContent, unlockContent } = require('./storage/local');
+const { logger } = require('./logger');
+
+const FINAL_STATUSES = ['approved', 'rejected'];
+// Monthly claims partitions are created this far ahead of the current month
+const PARTITIONS_AHEAD_MONTHS = 3;
+const PARTITION_NAME = /^claims_(\d{4})_(\d{2})$/;
+// Dropping a partition locks the whole claims table; give up quickly rather than queue
+// requests behind the lock, and retry on the next run
+const PARTITION_DROP_LOCK_TIMEOUT = '2s';
+
+// Archive tier for claims (see migrations/011_partition_claims_by_month.sql). Each run, on
+// one cluster worker:
+//   1. creates the claims partitions for the coming months
+//   2. moves approved and rejected claims not updated for `afterMonths` months, with their
+//      documents, to claims_archive / documents_archive in batches
+//   3. copies the files of archived documents into `coldDirectory` once no live document
+//      or upload session uses them, and removes the hot copy and its preview
+//   4. drops monthly partitions older than the cutoff that archival has emptied
+// Files in object storage are left where they are; a bucket lifecycle rule can transition them.
+class ClaimArchiver {
+    constructor({ pool, storage, coldDirectory, previewsDirectory, afterMonths = 12, batchSize = 500, intervalMs = 6 * 60 * 60 * 1000 }) {
+        this.pool = pool;
+        this.storage = storage;
+        this.coldDirectory = coldDirectory;
+        this.previewsDirectory = previewsDirectory;
+        this.afterMonths = afterMonths;
+        this.batchSize = batchSize;
+        this.intervalMs = intervalMs;
+        this.timer = null;
+        this.running = null;
+        this.stopped = false;
+    }
+
+    start() {
+        this.stopped = false;
+        const run = () => {
+            if (this.running) return;
+            this.running = this.run()
+                .catch(error => logger.error('Claim archival failed', { error }))
+                .finally(() => {
+                    this.running = null;
+                });
+        };
+        this.timer = setInterval(run, this.intervalMs);
+        this.timer.unref();
+        run();
+    }
+
+    // Resolves once the batch in progress (if any) has committed
+    stop() {
+        this.stopped = true;
+        clearInterval(this.timer);
+        this.timer = null;
+        return this.running || Promise.resolve();
+    }
+
+    cutoff() {
+        const cutoff = new Date();
+        cutoff.setMonth(cutoff.getMonth() - this.afterMonths);
+        return cutoff;
+    }
+
+    async run() {
+        const start = Date.now();
+        const now = new Date();
+        const through = new Date(now);
+        through.setMonth(through.getMonth() + PARTITIONS_AHEAD_MONTHS);
+        await this.pool.query('SELECT create_claim_partitions($1, $2)', [now, through]);
+        if (this.afterMonths <= 0) return;
+
+        const cutoff = this.cutoff();
+        const totals = { claims: 0, documents: 0, coldFiles: 0, droppedPartitions: 0 };
+        while (!this.stopped) {
+            const batch = await this.archiveBatch(cutoff);
+            totals.claims += batch.claims;
+            totals.documents += batch.documents.length;
+            totals.coldFiles += await this.moveToColdStorage(batch.documents);
+            if (batch.claims < this.batchSize) break;
+        }
+        if (!this.stopped) {
+            totals.droppedPartitions = await this.dropEmptyPartitions(cutoff);
+        }
+        if (totals.claims > 0 || totals.droppedPartitions > 0) {
+            logger.info('Archived finalized claims', { ...totals, cutoff, durationMs: Date.now() - start });
+        }
+    }
+
+    // Moves one batch of claims and their documents in a single transaction. SKIP LOCKED
+    // leaves claims that a PATCH is updating right now for the next run.
+    async archiveBatch(cutoff) {
+        return withTransaction(async client => {
+            const selected = await client.query(
+                `SELECT claim_id FROM claims
+                 WHERE status = ANY($1) AND updated_at < $2
+                 ORDER BY updated_at LIMIT $3
+                 FOR UPDATE SKIP LOCKED`,
+                [FINAL_STATUSES, cutoff, this.batchSize]
+            );
+            const claimIds = selected.rows.map(row => row.claim_id);
+            if (claimIds.length === 0) return { claims: 0, documents: [] };
+
+            const archivedAt = new Date();
+            await client.query(`
+                INSERT INTO claims_archive (claim_id, employee_name, employee_email, employee_id, department, claim_date,
+                                            amount, description, type, status, created_at, updated_at, idempotency_key, archived_at)
+                SELECT claim_id, employee_name, employee_email, employee_id, department, claim_date,
+                       amount, description, type, status, created_at, updated_at, idempotency_key, $2
+                FROM claims WHERE claim_id = ANY($1)
+            `, [claimIds, archivedAt]);
+            // Deleting the documents drops their previews rows and document_blobs references
+            const documents = await client.query(`
+                WITH moved AS (
+                    DELETE FROM documents WHERE claim_id = ANY($1)
+                    RETURNING id, claim_id, file_name, file_path, uploaded_at, content_hash, size_bytes
+                )
+                INSERT INTO documents_archive (id, claim_id, file_name, file_path, uploaded_at, content_hash, size_bytes)
+                SELECT * FROM moved
+                RETURNING file_path, content_hash
+            `, [claimIds]);
+            await client.query('DELETE FROM claims WHERE claim_id = ANY($1)', [claimIds]);
+            // The delete took the claims out of claim_totals; archived claims stay in the
+            // summary (see migrations/013_claim_totals_include_archive.sql). Same shard and key
+            // order as the trigger, see migrations/014_claim_totals_statement_trigger.sql
+            await client.query(`
+                INSERT INTO claim_totals (status, type, shard, claim_count, total_amount)
+                SELECT COALESCE(status, ''), COALESCE(type, ''), claim_totals_shard(), COUNT(*), COALESCE(SUM(amount), 0)
+                FROM claims_archive WHERE claim_id = ANY($1)
+                GROUP BY 1, 2
+                ORDER BY 1, 2
+                ON CONFLICT (status, type, shard) DO UPDATE
+                SET claim_count = claim_totals.claim_count + EXCLUDED.claim_count,
+                    total_amount = claim_totals.total_amount + EXCLUDED.total_amount
+            `, [claimIds]);
+            return { claims: claimIds.length, documents: documents.rows };
+        });
+    }
+
+    async moveToColdStorage(documents) {
+        const files = new Map();
+        for (const doc of documents) {
+            if (doc.file_path && this.storage.local.owns(doc.file_path)) {
+                files.set(doc.file_path, doc.content_hash ? doc.content_hash.trim() : null);
+            }
+        }
+        let moved = 0;
+        for (const [filePath, contentHash] of files) {
+            if (this.stopped) break;
+            try {
+                if (await this.moveFile(filePath, contentHash)) moved++;
+            } catch (error) {
+                // The archived rows keep the hot path, which still serves the file
+                logger.warn('Could not move archived document to cold storage', { filePath, error });
+            }
+        }
+        return moved;
+    }
+
+    async moveFile(filePath, contentHash) {
+        const coldPath = path.join(this.coldDirectory, path.basename(filePath));
+        // The exclusive content lock is held on its own connection from before the checks
+        // until the hot copy is gone. An upload that deduplicated onto the file references it
+        // under the shared lock (see storage/local.js), so it either committed before the
+        // checks below and keeps the file hot, or waits and then re-links it from its own copy.
+        const lockClient = contentHash ? await this.pool.connect() : null;
+        let releaseError;
+        try {
+            if (lockClient) {
+                await lockContent(lockClient, contentHash, { exclusive: true, session: true });
+            }
+            const copied = await withTransaction(async client => {
+                if (contentHash) {
+                    const blob = await client.query('SELECT 1 FROM document_blobs WHERE content_hash = $1 AND ref_count > 0', [contentHash]);
+                    if (blob.rows.length > 0) return false;
+                    const session = await client.query('SELECT 1 FROM upload_sessions WHERE content_hash = $1 LIMIT 1', [contentHash]);
+                    if (session.rows.length > 0) return false;
+                }
+                const live = await client.query('SELECT 1 FROM documents WHERE file_path = $1 LIMIT 1', [filePath]);
+                if (live.rows.length > 0) return false;
+
+                await copyInto(filePath, coldPath);
+                await client.query('UPDATE documents_archive SET file_path = $2 WHERE file_path = $1', [filePath, coldPath]);
+                if (contentHash) {
+                    await client.query('DELETE FROM document_blobs WHERE content_hash = $1 AND ref_count = 0', [contentHash]);
+                }
+                return true;
+            });
+            if (!copied) return false;
+
+            await fs.promises.unlink(filePath).catch(error => {
+                if (error.code !== 'ENOENT') throw error;
+            });
+            this.storage.local.remember(filePath, false);
+            if (contentHash) {
+                await fs.promises.unlink(path.join(this.previewsDirectory, `${contentHash}.webp`)).catch(() => {});
+            }
+            return true;
+        } finally {
+            if (lockClient) {
+                try {
+                    await unlockContent(lockClient, contentHash);
+                } catch (error) {
+                    // Discarding the connection ends its session, and with it the lock
+                    releaseError = error;
+                }
+                lockClient.release(releaseError);
+            }
+        }
+    }
+
+    async dropEmptyPartitions(cutoff) {
+        const result = await this.pool.query(`
+            SELECT c.relname FROM pg_inherits i JOIN pg_class c ON c.oid = i.inhrelid
+            WHERE i.inhparent = 'claims'::regclass
+        `);
+        let dropped = 0;
+        for (const { relname } of result.rows) {
+            const match = PARTITION_NAME.exec(relname);
+            if (!match) continue;
+            // The month after the partition's, i.e. its upper bound
+            const end = new Date(Number(match[1]), Number(match[2]), 1);
+            if (end > cutoff) continue;
+            try {
+                const removed = await withTransaction(async client => {
+                    await client.query(`SET LOCAL lock_timeout = '${PARTITION_DROP_LOCK_TIMEOUT}'`);
+                    // Pending claims from that month keep it alive
+                    const rows = await client.query(`SELECT 1 FROM ${relname} LIMIT 1`);
+                    if (rows.rows.length > 0) return false;
+                    await client.query(`ALTER TABLE claims DETACH PARTITION ${relname}`);
+                    await client.query(`DROP TABLE ${relname}`);
+                    return true;
+                });
+                if (removed) dropped++;
+            } catch (error) {
+                logger.warn('Could not drop empty claims partition', { partition: relname, error });
+            }
+        }
+        return dropped;
+    }
+}
+
+// Copies through a temp name and renames, so a crash never leaves a partial file at the
+// final path. Cold storage is usually another volume, where link() would fail.
+async function copyInto(source, target) {
+    try {
+        await fs.promises.access(target);
+        return;
+    } catch (error) {
+        // Not there yet
+    }
+    await fs.promises.mkdir(path.dirname(target), { recursive: true });
+    const temp = `${target}.${crypto.randomUUID()}.tmp`;
+    try {
+        await fs.promises.copyFile(source, temp);
+        await fs.promises.rename(temp, target);
+    } finally {
+        await fs.promises.unlink(temp).catch(() => {});
+    }
+}
+
+module.exports = { ClaimArchiver };
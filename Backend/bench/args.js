@@ -0,0 +1,34 @@
+// --name value / --flag parsing for the bench scripts; each option's type follows its default.
+// A bad argument ends the process with a usage message.
+function fail(message) {
+    console.error(message);
+    process.exit(2);
+}
+
+function parseArgs(argv, defaults) {
+    const options = { ...defaults };
+    for (let i = 0; i < argv.length; i++) {
+        const match = /^--([a-z-]+)(?:=(.*))?$/.exec(argv[i]);
+        if (!match || !(match[1] in defaults)) {
+            fail(`Unknown argument ${argv[i]}; expected one of ${Object.keys(defaults).map(name => `--${name}`).join(', ')}`);
+        }
+        const [, name, inline] = match;
+        if (typeof defaults[name] === 'boolean') {
+            options[name] = inline === undefined ? true : inline !== 'false';
+            continue;
+        }
+        const value = inline !== undefined ? inline : argv[++i];
+        if (value === undefined) {
+            fail(`--${name} needs a value`);
+        }
+        if (typeof defaults[name] === 'number') {
+            if (isNaN(Number(value))) fail(`--${name} must be a number`);
+            options[name] = Number(value);
+        } else {
+            options[name] = value;
+        }
+    }
+    return options;
+}
+
+module.exports = { parseArgs };
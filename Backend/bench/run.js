@@ -0,0 +1,278 @@
+// Drives a mixed workload against a running backend and reports throughput and latency
+// percentiles per scenario as JSON.
+//   node bench/run.js [--base-url http://localhost:3407] [--duration 30] [--warmup 5]
+//                     [--concurrency 16] [--mix submit=1,list=4,detail=4,documents=2,download=3,bulk=1]
+//                     [--upload-kb 200] [--out results.json] [--baseline previous.json]
+//                     [--max-regression 0.15]
+//
+// Seed first with bench/seed.js; reads and bulk updates only touch the seeded claims. Each
+// of --concurrency workers runs one request at a time, picking its scenario by --mix weight.
+// Requests that finish during the warmup are not counted. With --baseline the run exits
+// with status 1 when a scenario's p95 latency grows, or its throughput drops, by more than
+// --max-regression compared with that earlier result file.
+const fs = require('fs');
+const crypto = require('crypto');
+const { parseArgs } = require('./args');
+
+const options = parseArgs(process.argv.slice(2), {
+    'base-url': 'http://localhost:3407',
+    duration: 30,
+    warmup: 5,
+    concurrency: 16,
+    mix: 'submit=1,list=4,detail=4,documents=2,download=3,bulk=1',
+    'upload-kb': 200,
+    out: '',
+    baseline: '',
+    'max-regression': 0.15
+});
+
+const BASE_URL = options['base-url'].replace(/\/$/, '');
+const BULK_BATCH_SIZE = 20;
+const PERCENTILES = [50, 90, 95, 99];
+const CLAIM_TYPES = ['Medical', 'Travel', 'Education', 'Meal', 'Equipment', 'Other'];
+
+function pick(list) {
+    return list[Math.floor(Math.random() * list.length)];
+}
+
+// Reads the whole body so the timing covers the transfer, not just the headers
+async function request(path, init) {
+    const response = await fetch(`${BASE_URL}${path}`, init);
+    await response.arrayBuffer();
+    return response;
+}
+
+function samplePdf(size) {
+    const head = '%PDF-1.4\n% benchmark upload\n';
+    const tail = '\n%%EOF\n';
+    const padLength = Math.max(0, size - head.length - tail.length);
+    // Random bytes make every upload a new content hash, so none is deduplicated away
+    return Buffer.concat([Buffer.from(head), crypto.randomBytes(padLength), Buffer.from(tail)]);
+}
+
+const scenarios = {
+    // Employee form: one multipart claim with a single PDF
+    async submit() {
+        const employee = Math.floor(Math.random() * 899);
+        const form = new FormData();
+        form.append('empName', `Bench Employee ${employee}`);
+        form.append('empEmail', `bench${employee}@astrolitetech.com`);
+        form.append('empId', `ATS0${100 + employee}`);
+        form.append('department', 'Operations');
+        form.append('claimDate', new Date().toISOString().slice(0, 10));
+        form.append('amount', (10 + Math.random() * 4990).toFixed(2));
+        form.append('description', 'Benchmark submission');
+        form.append('type', pick(CLAIM_TYPES));
+        form.append('documents', new Blob([samplePdf(options['upload-kb'] * 1024)], { type: 'application/pdf' }), 'receipt.pdf');
+        return request('/api/claims', {
+            method: 'POST',
+            headers: { 'Idempotency-Key': `bench-run-${crypto.randomUUID()}` },
+            body: form
+        });
+    },
+    // HR dashboard refresh: first page of pending claims with their documents
+    list() {
+        return request('/api/claims?status=pending&limit=100&include=documents');
+    },
+    detail(data) {
+        return request(`/api/claims/${encodeURIComponent(pick(data.claimIds))}`);
+    },
+    documents(data) {
+        return request(`/api/claims/${encodeURIComponent(pick(data.claimIds))}/documents`);
+    },
+    download(data) {
+        return request(`/api/documents/${pick(data.documentIds)}`);
+    },
+    bulk(data) {
+        const claimIds = Array.from({ length: BULK_BATCH_SIZE }, () => pick(data.claimIds));
+        return request('/api/claims', {
+            method: 'PATCH',
+            headers: { 'Content-Type': 'application/json' },
+            body: JSON.stringify({ claimIds, status: pick(['approved', 'rejected']) })
+        });
+    }
+};
+
+function parseMix(mix) {
+    const weights = [];
+    for (const entry of mix.split(',').map(s => s.trim()).filter(Boolean)) {
+        const [name, weight] = entry.split('=');
+        if (!scenarios[name] || !(Number(weight) >= 0)) {
+            throw new Error(`Invalid --mix entry "${entry}"; scenarios are ${Object.keys(scenarios).join(', ')}`);
+        }
+        if (Number(weight) > 0) weights.push({ name, weight: Number(weight) });
+    }
+    if (weights.length === 0) throw new Error('--mix selects no scenario');
+    return weights;
+}
+
+function chooseScenario(weights, total) {
+    let point = Math.random() * total;
+    for (const entry of weights) {
+        point -= entry.weight;
+        if (point < 0) return entry.name;
+    }
+    return weights[weights.length - 1].name;
+}
+
+// Claim and document ids of the seeded data, read page by page through the listing API
+async function loadBenchData() {
+    const data = { claimIds: [], documentIds: [] };
+    let cursor = null;
+    do {
+        const query = `/api/claims?limit=500&include=documents&fields=employee_email${cursor ? `&cursor=${encodeURIComponent(cursor)}` : ''}`;
+        const response = await fetch(`${BASE_URL}${query}`);
+        if (!response.ok) {
+            throw new Error(`GET /api/claims returned ${response.status}`);
+        }
+        for (const claim of await response.json()) {
+            if (!claim.employee_email.startsWith('bench')) continue;
+            data.claimIds.push(claim.claim_id);
+            data.documentIds.push(...claim.documents.map(document => document.id));
+        }
+        cursor = response.headers.get('X-Next-Cursor');
+    } while (cursor);
+    if (data.claimIds.length === 0 || data.documentIds.length === 0) {
+        throw new Error('No benchmark claims found; run bench/seed.js first');
+    }
+    return data;
+}
+
+function percentile(sorted, p) {
+    if (sorted.length === 0) return 0;
+    return sorted[Math.min(sorted.length - 1, Math.ceil(p / 100 * sorted.length) - 1)];
+}
+
+function round(value) {
+    return Math.round(value * 100) / 100;
+}
+
+function summarize(results, measuredSeconds) {
+    const latencyMs = results.latencies.slice().sort((a, b) => a - b);
+    const latency = {};
+    for (const p of PERCENTILES) {
+        latency[`p${p}`] = round(percentile(latencyMs, p));
+    }
+    latency.max = round(latencyMs.length ? latencyMs[latencyMs.length - 1] : 0);
+    latency.mean = round(latencyMs.length ? latencyMs.reduce((sum, ms) => sum + ms, 0) / latencyMs.length : 0);
+    return {
+        requests: latencyMs.length,
+        errors: results.errors,
+        statuses: results.statuses,
+        throughput: round(latencyMs.length / measuredSeconds),
+        latencyMs: latency
+    };
+}
+
+async function run(data, weights) {
+    const totalWeight = weights.reduce((sum, entry) => sum + entry.weight, 0);
+    const results = Object.fromEntries(weights.map(({ name }) => [name, { latencies: [], errors: 0, statuses: {} }]));
+    const start = Date.now();
+    const measureFrom = start + options.warmup * 1000;
+    const end = measureFrom + options.duration * 1000;
+
+    async function worker() {
+        while (Date.now() < end) {
+            const name = chooseScenario(weights, totalWeight);
+            const began = process.hrtime.bigint();
+            let status;
+            try {
+                status = String((await scenarios[name](data)).status);
+            } catch (error) {
+                status = error.cause && error.cause.code ? error.cause.code : 'network_error';
+            }
+            if (Date.now() < measureFrom) continue;
+            const result = results[name];
+            result.latencies.push(Number(process.hrtime.bigint() - began) / 1e6);
+            result.statuses[status] = (result.statuses[status] || 0) + 1;
+            if (!/^[23]/.test(status)) result.errors++;
+        }
+    }
+
+    await Promise.all(Array.from({ length: options.concurrency }, worker));
+    const measuredSeconds = (Date.now() - measureFrom) / 1000;
+
+    const scenarioSummaries = {};
+    const all = { latencies: [], errors: 0, statuses: {} };
+    for (const [name, result] of Object.entries(results)) {
+        scenarioSummaries[name] = summarize(result, measuredSeconds);
+        all.latencies.push(...result.latencies);
+        all.errors += result.errors;
+        for (const [status, count] of Object.entries(result.statuses)) {
+            all.statuses[status] = (all.statuses[status] || 0) + count;
+        }
+    }
+    return {
+        startedAt: new Date(start).toISOString(),
+        baseUrl: BASE_URL,
+        durationSeconds: round(measuredSeconds),
+        warmupSeconds: options.warmup,
+        concurrency: options.concurrency,
+        mix: Object.fromEntries(weights.map(({ name, weight }) => [name, weight])),
+        seeded: { claims: data.claimIds.length, documents: data.documentIds.length },
+        total: summarize(all, measuredSeconds),
+        scenarios: scenarioSummaries
+    };
+}
+
+function compareWithBaseline(report, baseline) {
+    const limit = options['max-regression'];
+    const regressions = [];
+    for (const [name, current] of Object.entries(report.scenarios)) {
+        const previous = baseline.scenarios && baseline.scenarios[name];
+        if (!previous || previous.requests === 0 || current.requests === 0) continue;
+        if (previous.latencyMs.p95 > 0 && current.latencyMs.p95 > previous.latencyMs.p95 * (1 + limit)) {
+            regressions.push({ scenario: name, metric: 'p95', baseline: previous.latencyMs.p95, current: current.latencyMs.p95 });
+        }
+        if (current.throughput < previous.throughput * (1 - limit)) {
+            regressions.push({ scenario: name, metric: 'throughput', baseline: previous.throughput, current: current.throughput });
+        }
+    }
+    return regressions;
+}
+
+function printSummary(report) {
+    const rows = [['scenario', 'requests', 'errors', 'req/s', 'p50', 'p95', 'p99', 'max']];
+    for (const [name, summary] of [...Object.entries(report.scenarios), ['total', report.total]]) {
+        const { latencyMs } = summary;
+        rows.push([name, summary.requests, summary.errors, summary.throughput, latencyMs.p50, latencyMs.p95, latencyMs.p99, latencyMs.max].map(String));
+    }
+    const widths = rows[0].map((_, i) => Math.max(...rows.map(row => row[i].length)));
+    for (const row of rows) {
+        console.error(row.map((cell, i) => i === 0 ? cell.padEnd(widths[i]) : cell.padStart(widths[i])).join('  '));
+    }
+    console.error('(latencies in ms)');
+}
+
+async function main() {
+    const weights = parseMix(options.mix);
+    const data = await loadBenchData();
+    console.error(`Running ${options.concurrency} workers against ${BASE_URL} for ${options.warmup}s warmup + ${options.duration}s`
+        + ` (${data.claimIds.length} seeded claims, ${data.documentIds.length} documents)`);
+    const report = await run(data, weights);
+
+    if (options.baseline) {
+        const baseline = JSON.parse(fs.readFileSync(options.baseline, 'utf8'));
+        report.regressions = compareWithBaseline(report, baseline);
+    }
+
+    const output = JSON.stringify(report, null, 2) + '\n';
+    if (options.out) {
+        fs.writeFileSync(options.out, output);
+    } else {
+        process.stdout.write(output);
+    }
+    printSummary(report);
+
+    if (report.regressions && report.regressions.length > 0) {
+        for (const regression of report.regressions) {
+            console.error(`Regression in ${regression.scenario} ${regression.metric}: ${regression.baseline} -> ${regression.current}`);
+        }
+        process.exitCode = 1;
+    }
+}
+
+main().catch(error => {
+    console.error(`Benchmark failed: ${error.message}`);
+    process.exitCode = 1;
+});
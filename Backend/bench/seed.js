@@ -0,0 +1,131 @@
+// Seeds the database with synthetic claims and documents for bench/run.js.
+//   node bench/seed.js [--claims 10000] [--documents-per-claim 2] [--reset]
+//                      [--uploads-dir Uploads] [--stored-dir /app/Uploads]
+//
+// Run from the host against the compose stack with PGHOST=localhost PGPORT=5408. Document
+// bytes are written content-addressed into --uploads-dir (the host side of the backend's
+// Uploads volume) and recorded under --stored-dir, the path the container sees. Every seeded
+// claim carries an idempotency_key starting with "bench-", as do claims run.js submits, so
+// --reset removes exactly the benchmark's rows (and then seeds again only if --claims is given).
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+const { pool } = require('../db');
+const { storeByHash } = require('../storage/local');
+const { parseArgs } = require('./args');
+
+const BATCH_SIZE = 2000;
+const SAMPLE_DOCUMENT_SIZES = [40, 120, 250, 600, 1500].map(kb => kb * 1024);
+
+const options = parseArgs(process.argv.slice(2), {
+    claims: 10000,
+    'documents-per-claim': 2,
+    reset: false,
+    'uploads-dir': path.join(__dirname, '..', 'Uploads'),
+    'stored-dir': '/app/Uploads'
+});
+
+// A small valid PDF padded with a comment to the requested size
+function samplePdf(index, size) {
+    const head = `%PDF-1.4\n1 0 obj <</Type /Catalog /Pages 2 0 R>> endobj\n2 0 obj <</Type /Pages /Kids [3 0 R] /Count 1>> endobj\n`
+        + `3 0 obj <</Type /Page /Parent 2 0 R /MediaBox [0 0 595 842]>> endobj\n% benchmark sample ${index}\n`;
+    const tail = 'trailer <</Root 1 0 R>>\n%%EOF\n';
+    // Random padding, so downloads can't be shrunk by transport compression
+    const padLength = Math.max(0, size - head.length - tail.length - 2);
+    const padding = '%' + crypto.randomBytes(padLength).toString('base64').slice(0, padLength) + '\n';
+    return Buffer.from(head + padding + tail);
+}
+
+async function writeSampleDocuments() {
+    // Written next to the final files, like multer uploads, so storeByHash can link them
+    const incomingDir = path.join(options['uploads-dir'], '.incoming');
+    await fs.promises.mkdir(incomingDir, { recursive: true });
+    const samples = [];
+    for (const [i, size] of SAMPLE_DOCUMENT_SIZES.entries()) {
+        const data = samplePdf(i, size);
+        const contentHash = crypto.createHash('sha256').update(data).digest('hex');
+        const tempPath = path.join(incomingDir, `bench-${crypto.randomUUID()}`);
+        await fs.promises.writeFile(tempPath, data);
+        const stored = await storeByHash(options['uploads-dir'], tempPath, contentHash, '.pdf');
+        samples.push({
+            fileName: `receipt-${i + 1}.pdf`,
+            filePath: path.posix.join(options['stored-dir'], stored.filename),
+            contentHash,
+            size: data.length
+        });
+    }
+    return samples;
+}
+
+async function insertBatch(runId, offset, count, samples) {
+    const claims = await pool.query(`
+        INSERT INTO claims (claim_id, employee_name, employee_email, employee_id, department, claim_date,
+                            amount, description, type, status, created_at, updated_at, idempotency_key)
+        SELECT next_claim_id(t.created), 'Bench Employee ' || t.e, 'bench' || t.e || '@astrolitetech.com',
+               'ATS0' || (100 + t.e), (ARRAY['HR', 'IT', 'Finance', 'Marketing', 'Operations'])[1 + g % 5],
+               t.created::date, round((10 + random() * 4990)::numeric, 2), 'Benchmark claim number ' || g,
+               (ARRAY['Medical', 'Travel', 'Education', 'Meal', 'Equipment', 'Other'])[1 + g % 6],
+               (ARRAY['pending', 'pending', 'approved', 'rejected'])[1 + g % 4],
+               t.created, t.created, 'bench-seed-' || $3 || '-' || g
+        FROM generate_series($1::int, $2::int) AS g,
+             LATERAL (SELECT now()::timestamp - random() * interval '90 days' AS created, g % 899 AS e) AS t
+        RETURNING claim_id, created_at
+    `, [offset + 1, offset + count, runId]);
+
+    const perClaim = options['documents-per-claim'];
+    const rows = { claimIds: [], uploadedAt: [], fileNames: [], filePaths: [], hashes: [], sizes: [] };
+    claims.rows.forEach((claim, i) => {
+        for (let n = 0; n < perClaim; n++) {
+            const sample = samples[(offset + i + n) % samples.length];
+            rows.claimIds.push(claim.claim_id);
+            rows.uploadedAt.push(claim.created_at);
+            rows.fileNames.push(sample.fileName);
+            rows.filePaths.push(sample.filePath);
+            rows.hashes.push(sample.contentHash);
+            rows.sizes.push(sample.size);
+        }
+    });
+    if (rows.claimIds.length === 0) return;
+
+    // Seeded documents get no preview rendering; the benchmark measures the API, not libvips
+    await pool.query(`
+        WITH inserted AS (
+            INSERT INTO documents (claim_id, uploaded_at, file_name, file_path, content_hash, size_bytes)
+            SELECT * FROM unnest($1::varchar[], $2::timestamp[], $3::varchar[], $4::varchar[], $5::char(64)[], $6::bigint[])
+            RETURNING id
+        )
+        INSERT INTO document_previews (document_id, status, error)
+        SELECT id, 'failed', 'Benchmark seed' FROM inserted
+    `, [rows.claimIds, rows.uploadedAt, rows.fileNames, rows.filePaths, rows.hashes, rows.sizes]);
+}
+
+async function main() {
+    if (options.reset) {
+        const result = await pool.query("DELETE FROM claims WHERE idempotency_key LIKE 'bench-%'");
+        const archived = await pool.query("DELETE FROM claims_archive WHERE idempotency_key LIKE 'bench-%'");
+        console.error(`Removed ${result.rowCount + archived.rowCount} benchmark claims`);
+        if (!process.argv.some(arg => arg === '--claims' || arg.startsWith('--claims='))) return;
+    }
+
+    const samples = await writeSampleDocuments();
+    const runId = Date.now().toString(36);
+    const total = options.claims;
+    const start = Date.now();
+    for (let offset = 0; offset < total; offset += BATCH_SIZE) {
+        await insertBatch(runId, offset, Math.min(BATCH_SIZE, total - offset), samples);
+        console.error(`Seeded ${Math.min(offset + BATCH_SIZE, total)}/${total} claims`);
+    }
+    console.log(JSON.stringify({
+        claims: total,
+        documents: total * options['documents-per-claim'],
+        sampleDocuments: samples.length,
+        durationMs: Date.now() - start
+    }));
+}
+
+main()
+    .catch(error => {
+        console.error(`Seeding failed: ${error.message}`);
+        process.exitCode = 1;
+    })
+    .finally(() => pool.end());
@@ -0,0 +1,116 @@
+const { EventEmitter } = require('events');
+const { createClient } = require('./db');
+const { logger } = require('./logger');
+
+const CHANNEL = 'claim_changes';
+const HEARTBEAT_INTERVAL_MS = 25000;
+const MAX_RECONNECT_DELAY_MS = 30000;
+
+// Holds one LISTEN connection for the process and re-emits each claim_changes notification
+// as a 'change' event. After the connection drops and comes back it emits 'resync', since
+// anything published in between was missed.
+class ClaimChangeFeed extends EventEmitter {
+    constructor() {
+        super();
+        this.client = null;
+        this.reconnectDelay = 1000;
+        this.connectedOnce = false;
+        this.stopped = false;
+        this.subscribers = new Set();
+    }
+
+    async start() {
+        this.stopped = false;
+        const client = createClient();
+        this.client = client;
+        client.on('notification', message => {
+            try {
+                this.emit('change', JSON.parse(message.payload));
+            } catch (error) {
+                logger.warn('Ignoring malformed claim change notification', { error });
+            }
+        });
+        client.on('error', error => {
+            logger.error('Claim change feed connection error', { error });
+            this.reconnect(client);
+        });
+        client.on('end', () => this.reconnect(client));
+
+        try {
+            await client.connect();
+            await client.query(`LISTEN ${CHANNEL}`);
+            this.reconnectDelay = 1000;
+            if (this.connectedOnce) {
+                this.emit('resync');
+            }
+            this.connectedOnce = true;
+            logger.info('Claim change feed listening', { channel: CHANNEL });
+        } catch (error) {
+            logger.error('Claim change feed failed to connect', { error });
+            this.reconnect(client);
+        }
+    }
+
+    reconnect(client) {
+        if (this.stopped || this.client !== client) return;
+        this.client = null;
+        client.removeAllListeners('end');
+        client.end().catch(() => {});
+        const delay = this.reconnectDelay;
+        this.reconnectDelay = Math.min(this.reconnectDelay * 2, MAX_RECONNECT_DELAY_MS);
+        setTimeout(() => this.start(), delay).unref();
+    }
+
+    async stop() {
+        this.stopped = true;
+        if (this.client) {
+            const client = this.client;
+            this.client = null;
+            await client.end().catch(() => {});
+        }
+    }
+
+    // Express handler streaming changes to one browser as Server-Sent Events
+    subscribe(req, res) {
+        res.set({
+            'Content-Type': 'text/event-stream',
+            'Cache-Control': 'no-cache',
+            'Connection': 'keep-alive',
+            'X-Accel-Buffering': 'no'
+        });
+        res.flushHeaders();
+        res.write('retry: 5000\n\n');
+
+        const send = (event, data) => {
+            res.write(`event: ${event}\ndata: ${JSON.stringify(data)}\n\n`);
+            if (res.flush) res.flush();
+        };
+        const onChange = change => send('claim', change);
+        const onResync = () => send('resync', {});
+        const heartbeat = setInterval(() => res.write(': heartbeat\n\n'), HEARTBEAT_INTERVAL_MS);
+
+        this.on('change', onChange);
+        this.on('resync', onResync);
+        this.subscribers.add(res);
+        req.on('close', () => {
+            clearInterval(heartbeat);
+            this.off('change', onChange);
+            this.off('resync', onResync);
+            this.subscribers.delete(res);
+        });
+    }
+
+    // Ends every open stream, e.g. before the process exits; EventSource reconnects on its
+    // own (to another worker or instance) and the dashboards catch up from there
+    disconnectAll() {
+        for (const res of this.subscribers) {
+            res.end();
+        }
+    }
+}
+
+const changeFeed = new ClaimChangeFeed();
+// One listener per connected dashboard
+changeFeed.setMaxListeners(0);
+
+module.exports = { changeFeed };
@@ -0,0 +1,145 @@
+const { xlsxChunks } = require('./xlsx');
+const { logger } = require('./logger');
+
+// Rows per FETCH: one batch is all an export holds in memory at a time
+const EXPORT_BATCH_SIZE = 1000;
+// An export waits on its client between fetches; a slow download may take longer than
+// DB_IDLE_IN_TRANSACTION_TIMEOUT_MS allows an ordinary transaction to sit idle
+const EXPORT_IDLE_TIMEOUT_MS = Number(process.env.EXPORT_IDLE_TIMEOUT_MS) || 10 * 60 * 1000;
+
+// Columns of an export, in order. Values are selected as text so dates and amounts come out
+// exactly as stored, with no time zone or float conversion on the way.
+const EXPORT_COLUMNS = [
+    { key: 'claim_id', header: 'Claim ID', type: 'string', width: 16, sql: 'claim_id' },
+    { key: 'employee_name', header: 'Employee Name', type: 'string', width: 24, sql: 'employee_name' },
+    { key: 'employee_email', header: 'Employee Email', type: 'string', width: 30, sql: 'employee_email' },
+    { key: 'employee_id', header: 'Employee ID', type: 'string', width: 12, sql: 'employee_id' },
+    { key: 'department', header: 'Department', type: 'string', width: 16, sql: 'department' },
+    { key: 'type', header: 'Type', type: 'string', width: 12, sql: 'type' },
+    { key: 'claim_date', header: 'Claim Date', type: 'date', width: 12, sql: "to_char(claim_date, 'YYYY-MM-DD')" },
+    { key: 'amount', header: 'Amount', type: 'amount', width: 12, sql: 'amount::text' },
+    { key: 'status', header: 'Status', type: 'string', width: 10, sql: 'status' },
+    { key: 'description', header: 'Description', type: 'string', width: 40, sql: 'description' },
+    { key: 'created_at', header: 'Submitted (UTC)', type: 'datetime', width: 20, sql: "to_char(created_at, 'YYYY-MM-DD HH24:MI:SS')" },
+    { key: 'updated_at', header: 'Updated (UTC)', type: 'datetime', width: 20, sql: "to_char(updated_at, 'YYYY-MM-DD HH24:MI:SS')" }
+];
+
+const EXPORT_SELECT = EXPORT_COLUMNS.map(column => `${column.sql} AS ${column.key}`).join(', ');
+
+const FORMATS = {
+    csv: { contentType: 'text/csv; charset=utf-8', extension: 'csv' },
+    xlsx: { contentType: 'application/vnd.openxmlformats-officedocument.spreadsheetml.sheet', extension: 'xlsx' }
+};
+
+// Reads `SELECT <export columns> FROM claims <where> ORDER BY ...` through a server-side
+// cursor on one connection of `db`, yielding a batch of rows per FETCH. The next batch is
+// fetched only when the consumer asks for it, so a slow client slows the reads instead of
+// piling rows up in memory. One REPEATABLE READ transaction gives the export a single
+// snapshot. Ending the iteration early (a client that went away) rolls the cursor back.
+async function* exportBatches(db, where, values) {
+    const client = await db.connect();
+    let finished = false;
+    let releaseError;
+    try {
+        await client.query('BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY');
+        await client.query(`SET LOCAL idle_in_transaction_session_timeout = ${EXPORT_IDLE_TIMEOUT_MS}`);
+        await client.query({
+            text: `DECLARE claims_export NO SCROLL CURSOR FOR
+                   SELECT ${EXPORT_SELECT} FROM claims ${where} ORDER BY created_at, claim_id`,
+            values
+        });
+        while (true) {
+            const batch = await client.query(`FETCH ${EXPORT_BATCH_SIZE} FROM claims_export`);
+            if (batch.rows.length > 0) yield batch.rows;
+            if (batch.rows.length < EXPORT_BATCH_SIZE) break;
+        }
+        await client.query('COMMIT');
+        finished = true;
+    } finally {
+        if (!finished) {
+            try {
+                await client.query('ROLLBACK');
+            } catch (rollbackError) {
+                // The connection is unusable; have the pool discard it
+                releaseError = rollbackError;
+            }
+        }
+        client.release(releaseError);
+    }
+}
+
+// RFC 4180 field. Text starting with a formula character gets a leading apostrophe, so a
+// description such as "=HYPERLINK(...)" stays text when the file is opened in a spreadsheet.
+function csvField(value) {
+    if (value === null || value === undefined) return '';
+    let text = String(value);
+    if (/^[=+\-@\t\r]/.test(text)) text = `'${text}`;
+    return /[",\r\n]/.test(text) ? `"${text.replace(/"/g, '""')}"` : text;
+}
+
+async function* csvChunks(batches) {
+    // The byte order mark makes Excel read the file as UTF-8
+    yield '\uFEFF' + EXPORT_COLUMNS.map(column => csvField(column.header)).join(',') + '\r\n';
+    for await (const rows of batches) {
+        // Amounts and dates are written as selected; only text columns need the formula guard
+        yield rows.map(row => EXPORT_COLUMNS.map(column => column.type === 'string'
+            ? csvField(row[column.key])
+            : row[column.key] === null ? '' : row[column.key]).join(',') + '\r\n').join('');
+    }
+}
+
+// Writes each chunk to res, waiting for 'drain' whenever its buffer is full. Resolves with
+// false if the client disconnected first; the generator is then closed, ending its query.
+async function pipeChunks(chunks, res) {
+    const closed = new Promise(resolve => res.once('close', () => resolve('closed')));
+    const drained = () => Promise.race([new Promise(resolve => res.once('drain', resolve)), closed]);
+    try {
+        for await (const chunk of chunks) {
+            if (res.destroyed) return false;
+            if (!res.write(chunk) && await drained() === 'closed') return false;
+        }
+        res.end();
+        return true;
+    } finally {
+        // Closes the generator (and its cursor) when leaving early
+        await chunks.return();
+    }
+}
+
+// Streams every claim matching `where` to res in `format` (see FORMATS). The first batch is
+// read before any header is sent, so a failing query still gets a proper error response.
+async function streamClaimExport({ db, where, values, format, filename, res, log = logger }) {
+    const start = Date.now();
+    const batches = exportBatches(db, where, values);
+    const first = await batches.next();
+    let rows = 0;
+    const counted = (async function* () {
+        if (first.done) return;
+        rows += first.value.length;
+        yield first.value;
+        for await (const batch of batches) {
+            rows += batch.length;
+            yield batch;
+        }
+    })();
+
+    res.set({
+        'Content-Type': FORMATS[format].contentType,
+        'Content-Disposition': `attachment; filename="${filename}.${FORMATS[format].extension}"`,
+        'Cache-Control': 'no-store'
+    });
+    const chunks = format === 'xlsx' ? xlsxChunks(EXPORT_COLUMNS, counted, { sheetName: 'Claims' }) : csvChunks(counted);
+    try {
+        const completed = await pipeChunks(chunks, res);
+        log.info(completed ? 'Claim export finished' : 'Claim export abandoned by client', { format, rows, durationMs: Date.now() - start });
+    } catch (error) {
+        // Headers and part of the body are out; cutting the connection is the only way left
+        // to tell the client the file is incomplete
+        log.error('Claim export failed mid-stream', { format, rows, error });
+        res.destroy();
+    } finally {
+        await batches.return();
+    }
+}
+
+module.exports = { streamClaimExport, FORMATS, EXPORT_COLUMNS };
@@ -0,0 +1,79 @@
+const cluster = require('cluster');
+const os = require('os');
+const path = require('path');
+const { logger } = require('./logger');
+const { serveClusterMetrics } = require('./metrics');
+
+// Production entry point: forks one server.js worker per core (or WEB_CONCURRENCY). The
+// workers share the listening socket on port 3407, so connections are spread across them.
+// `node server.js` still runs a single process.
+//
+// SIGTERM/SIGINT are forwarded to every worker, which stops accepting connections, drains
+// in-flight requests and closes its database pool; the primary exits once they are all gone.
+// A worker that dies unexpectedly is replaced, with a growing delay if it keeps dying on start.
+
+const WORKER_COUNT = Number(process.env.WEB_CONCURRENCY) || os.availableParallelism?.() || os.cpus().length;
+const SHUTDOWN_TIMEOUT_MS = Number(process.env.SHUTDOWN_TIMEOUT_MS) || 30000;
+// A worker that exits sooner than this after starting counts as a crash loop
+const MIN_UPTIME_MS = 5000;
+const MAX_RESTART_DELAY_MS = 30000;
+
+cluster.setupPrimary({ exec: path.join(__dirname, 'server.js') });
+// A scrape of /metrics on any worker returns the metrics of all of them
+serveClusterMetrics();
+
+// Worker slots keep their index across restarts; slot 0 runs the once-per-deployment
+// background tasks (expired upload cleanup, claim archival); queued jobs run on every worker
+const slots = new Map();
+const restartDelays = [];
+let shuttingDown = false;
+
+function fork(index) {
+    const worker = cluster.fork({ WORKER_INDEX: String(index) });
+    slots.set(worker.id, { index, startedAt: Date.now() });
+    return worker;
+}
+
+cluster.on('exit', (worker, code, signal) => {
+    const slot = slots.get(worker.id);
+    slots.delete(worker.id);
+    if (shuttingDown) {
+        if (slots.size === 0) {
+            logger.info('All workers stopped');
+            process.exit(0);
+        }
+        return;
+    }
+
+    const uptime = Date.now() - slot.startedAt;
+    const crashLoop = uptime < MIN_UPTIME_MS;
+    const delay = crashLoop ? restartDelays[slot.index] || 1000 : 0;
+    restartDelays[slot.index] = crashLoop ? Math.min(delay * 2, MAX_RESTART_DELAY_MS) : 0;
+    logger.error('Worker exited; restarting', { pid: worker.process.pid, index: slot.index, code, signal, uptimeMs: uptime, delayMs: delay });
+    setTimeout(() => {
+        if (!shuttingDown) fork(slot.index);
+    }, delay);
+});
+
+function shutdown(signal) {
+    if (shuttingDown) return;
+    shuttingDown = true;
+    logger.info('Shutting down workers', { signal, workers: slots.size });
+    if (slots.size === 0) process.exit(0);
+    for (const worker of Object.values(cluster.workers)) {
+        worker.process.kill('SIGTERM');
+    }
+    // Workers enforce their own drain timeout; this only covers one that hangs regardless
+    setTimeout(() => {
+        logger.error('Workers did not stop in time; exiting', { remaining: slots.size });
+        process.exit(1);
+    }, SHUTDOWN_TIMEOUT_MS + 5000).unref();
+}
+
+process.on('SIGTERM', () => shutdown('SIGTERM'));
+process.on('SIGINT', () => shutdown('SIGINT'));
+
+logger.info('Starting workers', { workers: WORKER_COUNT });
+for (let i = 0; i < WORKER_COUNT; i++) {
+    fork(i);
+}
@@ -0,0 +1,61 @@
+const zlib = require('zlib');
+
+// Bodies smaller than this gain less from compression than the headers and CPU cost
+const MIN_COMPRESS_BYTES = 1024;
+
+const ENCODERS = {
+    // Quality 11 (the default) is meant for static assets; 4 keeps dynamic responses cheap
+    br: (body, cb) => zlib.brotliCompress(body, {
+        params: {
+            [zlib.constants.BROTLI_PARAM_QUALITY]: 4,
+            [zlib.constants.BROTLI_PARAM_SIZE_HINT]: body.length
+        }
+    }, cb),
+    gzip: (body, cb) => zlib.gzip(body, cb)
+};
+
+// Negotiated Brotli/gzip for res.json() bodies. Only JSON is touched: document downloads are
+// already-compressed PDFs and images, and the SSE stream must reach the client unbuffered.
+// Compression runs on the libuv thread pool, and the ETag is taken from the uncompressed
+// body so conditional requests behave the same with or without an encoding.
+function compressJson(req, res, next) {
+    const json = res.json.bind(res);
+
+    res.json = function (obj) {
+        const body = Buffer.from(JSON.stringify(obj));
+        res.vary('Accept-Encoding');
+        const encoding = req.method === 'HEAD' || body.length < MIN_COMPRESS_BYTES || res.get('Content-Encoding')
+            ? false
+            : req.acceptsEncodings('br', 'gzip');
+        if (!encoding || !ENCODERS[encoding]) {
+            return json(obj);
+        }
+
+        if (!res.get('Content-Type')) {
+            res.type('json');
+        }
+        const etag = req.app.get('etag fn');
+        if (etag && !res.get('ETag')) {
+            res.set('ETag', etag(body, 'utf8'));
+        }
+        if (req.fresh) {
+            res.status(304).end();
+            return res;
+        }
+
+        ENCODERS[encoding](body, (error, compressed) => {
+            if (error) {
+                req.log.warn('Response compression failed', { error, encoding });
+                res.set('Content-Length', body.length);
+                res.end(body);
+                return;
+            }
+            res.set({ 'Content-Encoding': encoding, 'Content-Length': compressed.length });
+            res.end(compressed);
+        });
+        return res;
+    };
+    next();
+}
+
+module.exports = { compressJson };
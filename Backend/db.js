@@ -0,0 +1,215 @@
+const crypto = require('crypto');
+const { Pool, Client } = require('pg');
+const { logger } = require('./logger');
+const { Gauge, Histogram } = require('./metrics');
+
+function numberEnv(name, fallback) {
+    const value = process.env[name];
+    return value === undefined || value === '' || isNaN(Number(value)) ? fallback : Number(value);
+}
+
+const connectionConfig = {
+    user: process.env.PGUSER || 'postgres',
+    host: process.env.PGHOST || 'postgres',
+    database: process.env.PGDATABASE || 'new_employee_db',
+    password: process.env.PGPASSWORD || 'admin123',
+    port: numberEnv('PGPORT', 5432)
+};
+
+// Pool settings per process. Under cluster.js every worker has its own pools, so Postgres
+// sees up to WEB_CONCURRENCY x DB_POOL_MAX connections (plus the replica's). A timeout of 0
+// disables it.
+const poolConfig = {
+    max: numberEnv('DB_POOL_MAX', 10),
+    idleTimeoutMillis: numberEnv('DB_IDLE_TIMEOUT_MS', 30000),
+    // Fail a request instead of queueing forever when every connection is busy
+    connectionTimeoutMillis: numberEnv('DB_CONNECTION_TIMEOUT_MS', 5000),
+    // Server-side limits, sent as startup parameters of each connection
+    statement_timeout: numberEnv('DB_STATEMENT_TIMEOUT_MS', 15000),
+    idle_in_transaction_session_timeout: numberEnv('DB_IDLE_IN_TRANSACTION_TIMEOUT_MS', 60000),
+    application_name: process.env.WORKER_INDEX ? `claims-backend-${process.env.WORKER_INDEX}` : 'claims-backend'
+};
+
+// Named prepared statements are parsed and planned once per connection. Turn them off
+// (DB_PREPARED_STATEMENTS=false) behind a transaction-pooling proxy such as PgBouncer,
+// where consecutive queries may land on different server connections.
+const PREPARED_STATEMENTS = process.env.DB_PREPARED_STATEMENTS !== 'false';
+// Each connection keeps every statement it has prepared, so the set of names is capped
+const MAX_PREPARED_STATEMENTS = 200;
+const statementNames = new Map();
+
+// PostgreSQL connection shared by the server and maintenance scripts
+const pool = new Pool({ ...connectionConfig, ...poolConfig });
+
+// Optional streaming replica for heavy, lag-tolerant reads (see readPool)
+const replicaPool = process.env.DB_REPLICA_HOST
+    ? new Pool({
+        ...connectionConfig,
+        ...poolConfig,
+        host: process.env.DB_REPLICA_HOST,
+        port: numberEnv('DB_REPLICA_PORT', connectionConfig.port),
+        max: numberEnv('DB_REPLICA_POOL_MAX', poolConfig.max)
+    })
+    : null;
+const REPLICA_MAX_LAG_MS = numberEnv('DB_REPLICA_MAX_LAG_MS', 5000);
+const REPLICA_CHECK_INTERVAL_MS = 5000;
+let replicaUsable = false;
+let replicaTimer = null;
+
+const pools = [['primary', pool], ['replica', replicaPool]].filter(([, target]) => target);
+
+const acquireDuration = new Histogram('db_pool_acquire_seconds', 'Time spent waiting for a pooled connection', ['pool'],
+    [0.0005, 0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 5]);
+const queryDuration = new Histogram('db_query_duration_seconds', 'Pool query and transaction durations, connection wait included', ['pool', 'operation']);
+new Gauge('db_pool_clients', 'Pooled connections by state', ['pool', 'state'], () => pools.flatMap(([name, target]) => [
+    { labels: { pool: name, state: 'active' }, value: target.totalCount - target.idleCount },
+    { labels: { pool: name, state: 'idle' }, value: target.idleCount },
+    { labels: { pool: name, state: 'waiting' }, value: target.waitingCount }
+]));
+
+const OPERATIONS = new Set(['select', 'insert', 'update', 'delete', 'with']);
+
+function operationOf(config) {
+    const text = typeof config === 'string' ? config : config && config.text;
+    const match = /^\s*([A-Za-z]+)/.exec(text || '');
+    const keyword = match ? match[1].toLowerCase() : '';
+    return OPERATIONS.has(keyword) ? keyword : 'other';
+}
+
+// Times connection checkout (pool.query goes through connect() as well) and promise-style
+// queries; callback-style calls pass through untimed
+function instrumentPool(name, target) {
+    const connect = target.connect.bind(target);
+    target.connect = callback => {
+        const done = acquireDuration.startTimer({ pool: name });
+        if (callback) {
+            return connect((error, client, release) => {
+                done();
+                callback(error, client, release);
+            });
+        }
+        return connect().finally(() => done());
+    };
+
+    const query = target.query.bind(target);
+    target.query = (config, values, callback) => {
+        if (typeof values === 'function' || typeof callback === 'function') {
+            return query(config, values, callback);
+        }
+        const done = queryDuration.startTimer({ pool: name, operation: operationOf(config) });
+        return query(config, values).finally(() => done());
+    };
+}
+
+for (const [name, target] of pools) {
+    instrumentPool(name, target);
+    // An idle-pool error (e.g. the server restarting) is reported, not thrown at the process
+    target.on('error', error => logger.error('Idle database connection failed', { pool: name, error }));
+}
+
+// Query config for a hot statement: named by a hash of its text, so identical SQL reuses one
+// prepared statement however it was built
+function prepared(text, values) {
+    if (!PREPARED_STATEMENTS) return { text, values };
+    let name = statementNames.get(text);
+    if (!name) {
+        if (statementNames.size >= MAX_PREPARED_STATEMENTS) return { text, values };
+        name = `q_${crypto.createHash('sha1').update(text).digest('hex').slice(0, 16)}`;
+        statementNames.set(text, name);
+    }
+    return { name, text, values };
+}
+
+// The replica serves reads only while it is reachable and close enough behind the primary;
+// otherwise reads fall back to the primary. A replica that has replayed everything it
+// received counts as current even when the primary has been idle for a while.
+async function checkReplica() {
+    try {
+        const result = await replicaPool.query(`
+            SELECT CASE
+                WHEN pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0
+                ELSE COALESCE(EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()) * 1000, 0)
+            END::float8 AS lag_ms
+        `);
+        const lagMs = result.rows[0].lag_ms;
+        const usable = lagMs <= REPLICA_MAX_LAG_MS;
+        if (usable !== replicaUsable) {
+            logger.info(usable ? 'Read replica in use' : 'Read replica lagging; reading from primary', { lagMs });
+        }
+        replicaUsable = usable;
+    } catch (error) {
+        if (replicaUsable) {
+            logger.warn('Read replica unavailable; reading from primary', { error });
+        }
+        replicaUsable = false;
+    }
+}
+
+function startReplicaMonitor() {
+    if (!replicaPool || replicaTimer) return Promise.resolve();
+    replicaTimer = setInterval(checkReplica, REPLICA_CHECK_INTERVAL_MS);
+    replicaTimer.unref();
+    return checkReplica();
+}
+
+// Pool-like target for reads that may be slightly stale: the replica when one is configured
+// and healthy, the primary otherwise
+const readPool = {
+    query(...args) {
+        return (replicaUsable ? replicaPool : pool).query(...args);
+    },
+    // A client of the same pool, for reads that span several statements (cursors)
+    connect() {
+        return (replicaUsable ? replicaPool : pool).connect();
+    }
+};
+
+async function closePools() {
+    clearInterval(replicaTimer);
+    replicaTimer = null;
+    await Promise.all([pool.end(), replicaPool && replicaPool.end()]);
+}
+
+// Runs fn(client) inside BEGIN/COMMIT on a single checked-out client, rolling back on error.
+// A transaction Postgres aborted as a deadlock victim (SQLSTATE 40P01) is run again up to
+// `deadlockRetries` times; fn must be safe to repeat.
+async function withTransaction(fn, { deadlockRetries = 0 } = {}) {
+    for (let attempt = 0; ; attempt++) {
+        try {
+            return await runTransaction(fn);
+        } catch (error) {
+            if (error.code !== '40P01' || attempt >= deadlockRetries) throw error;
+            logger.warn('Transaction deadlocked; retrying', { attempt: attempt + 1 });
+        }
+    }
+}
+
+async function runTransaction(fn) {
+    const done = queryDuration.startTimer({ pool: 'primary', operation: 'transaction' });
+    const client = await pool.connect();
+    let releaseError;
+    try {
+        await client.query('BEGIN');
+        const result = await fn(client);
+        await client.query('COMMIT');
+        return result;
+    } catch (error) {
+        try {
+            await client.query('ROLLBACK');
+        } catch (rollbackError) {
+            // The connection is unusable; have the pool discard it
+            releaseError = rollbackError;
+        }
+        throw error;
+    } finally {
+        client.release(releaseError);
+        done();
+    }
+}
+
+// Dedicated connection outside the pool, e.g. for LISTEN sessions that stay open
+function createClient() {
+    return new Client(connectionConfig);
+}
+
+module.exports = { pool, readPool, prepared, withTransaction, createClient, startReplicaMonitor, closePools };
@@ -0,0 +1,166 @@
+const { logger } = require('./logger');
+const { Counter, Histogram } = require('./metrics');
+
+const jobsProcessed = new Counter('jobs_processed_total', 'Background job attempts by outcome (done, retry, dead)', ['kind', 'outcome']);
+const jobDuration = new Histogram('job_duration_seconds', 'Background job handler durations', ['kind']);
+
+// Postgres-backed job queue (see migrations/012_job_queue.sql). Requests enqueue jobs inside
+// their own transaction, so a job exists exactly when the rows it is about were committed.
+// Every process runs a JobQueue: each poll claims due jobs of the registered kinds with
+// FOR UPDATE SKIP LOCKED, so processes never wait on or double-run each other's jobs, then
+// runs them outside any transaction under a lease of `leaseMs`. A handler that throws is
+// retried with exponential backoff until the job's max_attempts, then the job is moved to
+// job_dead_letters. Handlers should be idempotent: a job whose process died mid-run is run
+// again once its lease expires.
+class JobQueue {
+    constructor({ pool, concurrency = 4, pollIntervalMs = 1000, leaseMs = 5 * 60 * 1000 }) {
+        this.pool = pool;
+        this.concurrency = concurrency;
+        this.pollIntervalMs = pollIntervalMs;
+        this.leaseMs = leaseMs;
+        this.kinds = new Map();
+        this.active = 0;
+        this.timer = null;
+        this.polling = null;
+        this.pollAgain = false;
+        this.stopped = true;
+        this.idle = null;
+    }
+
+    // handler(payload, job) runs each job of `kind`; job carries attempts (this one included)
+    // and maxAttempts. `concurrency` caps how many of this kind one process runs at once.
+    // Until a kind is registered its jobs wait in the table.
+    register(kind, handler, { concurrency = this.concurrency, backoffMs = 1000, maxBackoffMs = 10 * 60 * 1000 } = {}) {
+        this.kinds.set(kind, { handler, concurrency, backoffMs, maxBackoffMs, active: 0 });
+        this.wake();
+    }
+
+    // Adds one job per payload. Pass the transaction's client to enqueue atomically with the
+    // caller's writes, then call wake() once it has committed.
+    async enqueue(db, kind, payloads, { maxAttempts = 5, delayMs = 0 } = {}) {
+        if (payloads.length === 0) return;
+        await db.query(
+            `INSERT INTO jobs (kind, payload, max_attempts, run_at)
+             SELECT $1, payload, $3, CURRENT_TIMESTAMP + $4::int * interval '1 millisecond'
+             FROM jsonb_array_elements($2::jsonb) AS payload`,
+            [kind, JSON.stringify(payloads), maxAttempts, delayMs]
+        );
+    }
+
+    start() {
+        this.stopped = false;
+        this.timer = setInterval(() => this.wake(), this.pollIntervalMs);
+        this.timer.unref();
+        this.wake();
+    }
+
+    // Stops claiming jobs and resolves once the running ones have finished. Jobs still queued
+    // stay in the table for the next poll of any process.
+    stop() {
+        this.stopped = true;
+        clearInterval(this.timer);
+        this.timer = null;
+        return (this.polling || Promise.resolve()).then(() => {
+            if (this.active === 0) return;
+            return new Promise(resolve => {
+                this.idle = resolve;
+            });
+        });
+    }
+
+    // Polls now instead of at the next interval; a poll already running polls once more
+    wake() {
+        if (this.stopped) return;
+        if (this.polling) {
+            this.pollAgain = true;
+            return;
+        }
+        this.polling = this.poll()
+            .catch(error => logger.error('Job poll failed', { error }))
+            .finally(() => {
+                this.polling = null;
+                if (this.pollAgain) {
+                    this.pollAgain = false;
+                    this.wake();
+                }
+            });
+    }
+
+    async poll() {
+        for (const [kind, options] of this.kinds) {
+            const slots = Math.min(this.concurrency - this.active, options.concurrency - options.active);
+            if (this.stopped || slots <= 0) continue;
+            const claimed = await this.pool.query(
+                `UPDATE jobs SET attempts = attempts + 1, locked_until = CURRENT_TIMESTAMP + $3::int * interval '1 millisecond'
+                 WHERE id IN (
+                     SELECT id FROM jobs
+                     WHERE kind = $1 AND run_at <= CURRENT_TIMESTAMP
+                       AND (locked_until IS NULL OR locked_until < CURRENT_TIMESTAMP)
+                     ORDER BY run_at, id
+                     LIMIT $2
+                     FOR UPDATE SKIP LOCKED
+                 )
+                 RETURNING id, kind, payload, attempts, max_attempts, created_at`,
+                [kind, slots, this.leaseMs]
+            );
+            for (const job of claimed.rows) {
+                this.run(job, options);
+            }
+        }
+    }
+
+    run(job, options) {
+        this.active++;
+        options.active++;
+        const done = jobDuration.startTimer({ kind: job.kind });
+        Promise.resolve()
+            .then(() => options.handler(job.payload, { id: job.id, attempts: job.attempts, maxAttempts: job.max_attempts }))
+            .then(
+                () => this.complete(job),
+                error => this.fail(job, options, error)
+            )
+            .catch(error => logger.error('Could not record job outcome', { jobId: job.id, kind: job.kind, error }))
+            .finally(() => {
+                done();
+                this.active--;
+                options.active--;
+                if (this.active === 0 && this.idle) {
+                    this.idle();
+                    this.idle = null;
+                }
+                this.wake();
+            });
+    }
+
+    async complete(job) {
+        await this.pool.query('DELETE FROM jobs WHERE id = $1', [job.id]);
+        jobsProcessed.inc({ kind: job.kind, outcome: 'done' });
+    }
+
+    async fail(job, options, error) {
+        const message = error && error.message ? error.message : String(error);
+        if (job.attempts >= job.max_attempts) {
+            logger.error('Job failed permanently', { jobId: job.id, kind: job.kind, payload: job.payload, attempts: job.attempts, error });
+            await this.pool.query(
+                `WITH failed AS (DELETE FROM jobs WHERE id = $1 RETURNING id, kind, payload, attempts, created_at)
+                 INSERT INTO job_dead_letters (id, kind, payload, attempts, last_error, created_at)
+                 SELECT id, kind, payload, attempts, $2, created_at FROM failed`,
+                [job.id, message]
+            );
+            jobsProcessed.inc({ kind: job.kind, outcome: 'dead' });
+            return;
+        }
+        // Jitter spreads out retries of jobs that failed together, e.g. during an outage
+        const backoff = Math.min(options.maxBackoffMs, options.backoffMs * 2 ** (job.attempts - 1));
+        const delayMs = Math.round(backoff * (0.5 + Math.random() / 2));
+        logger.warn('Job failed; will retry', { jobId: job.id, kind: job.kind, payload: job.payload, attempts: job.attempts, delayMs, error });
+        await this.pool.query(
+            `UPDATE jobs SET run_at = CURRENT_TIMESTAMP + $2::int * interval '1 millisecond', locked_until = NULL, last_error = $3
+             WHERE id = $1`,
+            [job.id, delayMs, message]
+        );
+        jobsProcessed.inc({ kind: job.kind, outcome: 'retry' });
+    }
+}
+
+module.exports = { JobQueue };
@@ -0,0 +1,156 @@
+const fs = require('fs');
+const crypto = require('crypto');
+
+const LEVELS = { debug: 10, info: 20, warn: 30, error: 40 };
+
+const config = {
+    level: LEVELS[process.env.LOG_LEVEL] ? process.env.LOG_LEVEL : 'info',
+    // Fraction of requests whose debug/info lines are kept; warn and error are always written
+    sampleRate: process.env.LOG_SAMPLE_RATE !== undefined ? Number(process.env.LOG_SAMPLE_RATE) : 1,
+    flushIntervalMs: Number(process.env.LOG_FLUSH_INTERVAL_MS) || 100,
+    maxBufferBytes: Number(process.env.LOG_MAX_BUFFER_BYTES) || 1024 * 1024
+};
+
+// Batches lines in memory and writes them through an fs.WriteStream, which runs on the
+// libuv thread pool rather than blocking the event loop like process.stdout on a pipe.
+class BufferedTransport {
+    constructor({ file, flushIntervalMs, maxBufferBytes }) {
+        this.fd = file ? fs.openSync(file, 'a') : 1;
+        this.stream = fs.createWriteStream(null, { fd: this.fd, autoClose: false });
+        this.flushIntervalMs = flushIntervalMs;
+        this.maxBufferBytes = maxBufferBytes;
+        this.chunks = [];
+        this.bufferedBytes = 0;
+        this.pendingBytes = 0;
+        this.dropped = 0;
+        this.timer = null;
+    }
+
+    write(line) {
+        if (this.bufferedBytes + this.pendingBytes >= this.maxBufferBytes) {
+            // The sink can't keep up; shed load instead of growing the heap
+            this.dropped++;
+            return;
+        }
+        this.chunks.push(line);
+        this.bufferedBytes += line.length;
+        if (this.bufferedBytes >= this.maxBufferBytes / 4) {
+            this.flush();
+        } else if (!this.timer) {
+            this.timer = setTimeout(() => this.flush(), this.flushIntervalMs);
+            this.timer.unref();
+        }
+    }
+
+    takeBuffer() {
+        if (this.timer) {
+            clearTimeout(this.timer);
+            this.timer = null;
+        }
+        if (this.dropped > 0) {
+            this.chunks.push(formatLine('warn', 'Log lines dropped due to backpressure', { dropped: this.dropped }));
+            this.dropped = 0;
+        }
+        const data = this.chunks.join('');
+        this.chunks = [];
+        this.bufferedBytes = 0;
+        return data;
+    }
+
+    flush() {
+        const data = this.takeBuffer();
+        if (!data) return;
+        const bytes = Buffer.byteLength(data);
+        this.pendingBytes += bytes;
+        this.stream.write(data, () => {
+            this.pendingBytes -= bytes;
+        });
+    }
+
+    // Used on process exit, when queued async writes would never complete
+    flushSync() {
+        const data = this.takeBuffer();
+        if (data) {
+            try {
+                fs.writeSync(this.fd, data);
+            } catch (error) {
+                // Nothing left to report to
+            }
+        }
+    }
+}
+
+function serializeError(error) {
+    return { message: error.message, code: error.code, stack: error.stack };
+}
+
+function formatLine(level, msg, fields) {
+    const entry = { time: new Date().toISOString(), level, msg };
+    for (const [key, value] of Object.entries(fields)) {
+        entry[key] = value instanceof Error ? serializeError(value) : value;
+    }
+    return JSON.stringify(entry) + '\n';
+}
+
+const transport = new BufferedTransport({
+    file: process.env.LOG_FILE,
+    flushIntervalMs: config.flushIntervalMs,
+    maxBufferBytes: config.maxBufferBytes
+});
+
+process.on('exit', () => transport.flushSync());
+
+class Logger {
+    constructor(bindings = {}, sampled = true) {
+        this.bindings = bindings;
+        this.sampled = sampled;
+    }
+
+    // A child logger carries extra fields (e.g. requestId) on every line it writes
+    child(bindings, sampled = this.sampled) {
+        return new Logger({ ...this.bindings, ...bindings }, sampled);
+    }
+
+    isLevelEnabled(level) {
+        if (LEVELS[level] < LEVELS[config.level]) return false;
+        return this.sampled || LEVELS[level] >= LEVELS.warn;
+    }
+
+    log(level, msg, fields = {}) {
+        if (!this.isLevelEnabled(level)) return;
+        transport.write(formatLine(level, msg, { ...this.bindings, ...fields }));
+    }
+
+    debug(msg, fields) { this.log('debug', msg, fields); }
+    info(msg, fields) { this.log('info', msg, fields); }
+    warn(msg, fields) { this.log('warn', msg, fields); }
+    error(msg, fields) { this.log('error', msg, fields); }
+}
+
+const logger = new Logger();
+
+// Assigns a correlation ID (honouring an incoming X-Request-Id), exposes req.log and
+// writes one access line per request when the response finishes.
+function requestLogger(req, res, next) {
+    const requestId = req.get('X-Request-Id') || crypto.randomUUID();
+    const sampled = config.sampleRate >= 1 || Math.random() < config.sampleRate;
+    const start = process.hrtime.bigint();
+
+    req.id = requestId;
+    req.log = logger.child({ requestId }, sampled);
+    res.set('X-Request-Id', requestId);
+
+    res.on('finish', () => {
+        const durationMs = Number(process.hrtime.bigint() - start) / 1e6;
+        const level = res.statusCode >= 500 ? 'error' : res.statusCode >= 400 ? 'warn' : 'info';
+        req.log.log(level, 'Request completed', {
+            method: req.method,
+            path: req.originalUrl,
+            status: res.statusCode,
+            durationMs: Math.round(durationMs * 100) / 100
+        });
+    });
+    next();
+}
+
+module.exports = { logger, requestLogger };
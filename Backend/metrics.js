@@ -0,0 +1,255 @@
+const cluster = require('cluster');
+const crypto = require('crypto');
+const { monitorEventLoopDelay } = require('perf_hooks');
+
+// Minimal Prometheus client: counters, gauges and histograms rendered in the text exposition
+// format. Under cluster.js each worker keeps its own registry and samples carry a `worker`
+// label; GET /metrics asks the primary to gather every worker's snapshot, so one scrape
+// covers the whole process tree (rates and quantiles are then summed across workers, e.g.
+// histogram_quantile(0.95, sum by (le, route) (rate(http_request_duration_seconds_bucket[5m])))).
+
+const DEFAULT_BUCKETS = [0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10];
+const COLLECT_TIMEOUT_MS = 2000;
+const WORKER_LABEL = process.env.WORKER_INDEX !== undefined ? { worker: process.env.WORKER_INDEX } : {};
+
+const families = new Map();
+
+function labelKey(labelNames, labels) {
+    return labelNames.map(name => labels[name] === undefined ? '' : String(labels[name])).join('\u0000');
+}
+
+class Metric {
+    constructor(type, name, help, labelNames) {
+        if (families.has(name)) {
+            throw new Error(`Metric ${name} is already registered`);
+        }
+        this.type = type;
+        this.name = name;
+        this.help = help;
+        this.labelNames = labelNames;
+        this.series = new Map();
+        families.set(name, this);
+    }
+
+    seriesFor(labels, create) {
+        const key = labelKey(this.labelNames, labels);
+        let series = this.series.get(key);
+        if (!series) {
+            series = create(labels);
+            this.series.set(key, series);
+        }
+        return series;
+    }
+}
+
+class Counter extends Metric {
+    constructor(name, help, labelNames = []) {
+        super('counter', name, help, labelNames);
+    }
+
+    inc(labels = {}, value = 1) {
+        this.seriesFor(labels, () => ({ labels, value: 0 })).value += value;
+    }
+
+    samples() {
+        return [...this.series.values()].map(series => ({ name: this.name, labels: series.labels, value: series.value }));
+    }
+}
+
+// A gauge either holds set() values or reads them from `collect` at scrape time
+class Gauge extends Metric {
+    constructor(name, help, labelNames = [], collect = null) {
+        super('gauge', name, help, labelNames);
+        this.collect = collect;
+    }
+
+    set(labels, value) {
+        this.seriesFor(labels, () => ({ labels, value: 0 })).value = value;
+    }
+
+    samples() {
+        if (this.collect) {
+            return this.collect().map(({ labels = {}, value }) => ({ name: this.name, labels, value }));
+        }
+        return [...this.series.values()].map(series => ({ name: this.name, labels: series.labels, value: series.value }));
+    }
+}
+
+class Histogram extends Metric {
+    constructor(name, help, labelNames = [], buckets = DEFAULT_BUCKETS) {
+        super('histogram', name, help, labelNames);
+        this.buckets = buckets;
+    }
+
+    observe(labels, seconds) {
+        const series = this.seriesFor(labels, () => ({ labels, counts: this.buckets.map(() => 0), sum: 0, count: 0 }));
+        for (let i = 0; i < this.buckets.length; i++) {
+            if (seconds <= this.buckets[i]) series.counts[i]++;
+        }
+        series.sum += seconds;
+        series.count++;
+    }
+
+    // Returns a function that records the time elapsed since startTimer() was called
+    startTimer(labels = {}) {
+        const start = process.hrtime.bigint();
+        return (extraLabels = {}) => {
+            this.observe({ ...labels, ...extraLabels }, Number(process.hrtime.bigint() - start) / 1e9);
+        };
+    }
+
+    samples() {
+        const samples = [];
+        for (const series of this.series.values()) {
+            this.buckets.forEach((bucket, i) => {
+                samples.push({ name: `${this.name}_bucket`, labels: { ...series.labels, le: String(bucket) }, value: series.counts[i] });
+            });
+            samples.push({ name: `${this.name}_bucket`, labels: { ...series.labels, le: '+Inf' }, value: series.count });
+            samples.push({ name: `${this.name}_sum`, labels: series.labels, value: series.sum });
+            samples.push({ name: `${this.name}_count`, labels: series.labels, value: series.count });
+        }
+        return samples;
+    }
+}
+
+// Event-loop delay since the previous scrape; a busy loop delays every request in the worker.
+// The monitor's timer interval is part of each recorded delay, so it is subtracted.
+const EVENT_LOOP_RESOLUTION_MS = 20;
+const eventLoopDelay = monitorEventLoopDelay({ resolution: EVENT_LOOP_RESOLUTION_MS });
+eventLoopDelay.enable();
+
+function delaySeconds(nanoseconds) {
+    return Math.max(0, nanoseconds / 1e9 - EVENT_LOOP_RESOLUTION_MS / 1000);
+}
+
+new Gauge('nodejs_eventloop_lag_seconds', 'Event loop delay since the previous scrape', ['quantile'], () => {
+    const samples = [0.5, 0.9, 0.99].map(q => ({
+        labels: { quantile: String(q) },
+        value: delaySeconds(eventLoopDelay.percentile(q * 100))
+    }));
+    samples.push({ labels: { quantile: '1' }, value: delaySeconds(eventLoopDelay.max) });
+    eventLoopDelay.reset();
+    return samples;
+});
+
+new Gauge('process_resident_memory_bytes', 'Resident set size', [], () => [{ value: process.memoryUsage.rss() }]);
+new Gauge('nodejs_heap_used_bytes', 'V8 heap in use', [], () => [{ value: process.memoryUsage().heapUsed }]);
+
+// This process's families as plain data (sent over IPC under cluster.js)
+function snapshot() {
+    return [...families.values()].map(metric => ({
+        name: metric.name,
+        help: metric.help,
+        type: metric.type,
+        samples: metric.samples().map(sample => ({ ...sample, labels: { ...WORKER_LABEL, ...sample.labels } }))
+    }));
+}
+
+function escapeLabel(value) {
+    return String(value).replace(/\\/g, '\\\\').replace(/\n/g, '\\n').replace(/"/g, '\\"');
+}
+
+function formatValue(value) {
+    if (value === Infinity) return '+Inf';
+    if (value === -Infinity) return '-Inf';
+    return Number.isFinite(value) ? String(value) : 'NaN';
+}
+
+// Renders one or more snapshots; samples of the same family are grouped under a single
+// HELP/TYPE header as the format requires
+function render(snapshots) {
+    const merged = new Map();
+    for (const familyList of snapshots) {
+        for (const family of familyList) {
+            if (!merged.has(family.name)) {
+                merged.set(family.name, { ...family, samples: [] });
+            }
+            merged.get(family.name).samples.push(...family.samples);
+        }
+    }
+
+    const lines = [];
+    for (const family of merged.values()) {
+        lines.push(`# HELP ${family.name} ${family.help}`);
+        lines.push(`# TYPE ${family.name} ${family.type}`);
+        for (const sample of family.samples) {
+            const labels = Object.entries(sample.labels)
+                .filter(([, value]) => value !== undefined && value !== '')
+                .map(([name, value]) => `${name}="${escapeLabel(value)}"`);
+            lines.push(`${sample.name}${labels.length ? `{${labels.join(',')}}` : ''} ${formatValue(sample.value)}`);
+        }
+    }
+    return lines.join('\n') + '\n';
+}
+
+const pendingCollections = new Map();
+
+// Every worker's snapshot when running under cluster.js, this process's otherwise
+function collect() {
+    if (!cluster.isWorker || !process.send) {
+        return Promise.resolve(render([snapshot()]));
+    }
+    const requestId = crypto.randomUUID();
+    return new Promise(resolve => {
+        const timer = setTimeout(() => {
+            pendingCollections.delete(requestId);
+            resolve(render([snapshot()]));
+        }, COLLECT_TIMEOUT_MS + 500);
+        pendingCollections.set(requestId, snapshots => {
+            clearTimeout(timer);
+            resolve(render(snapshots));
+        });
+        process.send({ type: 'metrics:collect', requestId });
+    });
+}
+
+if (cluster.isWorker) {
+    process.on('message', message => {
+        if (!message || typeof message.type !== 'string') return;
+        if (message.type === 'metrics:snapshot') {
+            process.send({ type: 'metrics:snapshot', requestId: message.requestId, families: snapshot() });
+        } else if (message.type === 'metrics:collected') {
+            const done = pendingCollections.get(message.requestId);
+            pendingCollections.delete(message.requestId);
+            if (done) done(message.snapshots);
+        }
+    });
+}
+
+// Primary side of collect(), installed by cluster.js: asks every worker for a snapshot and
+// hands whatever arrived before the timeout to the worker serving the scrape
+function serveClusterMetrics() {
+    const requests = new Map();
+
+    cluster.on('message', (worker, message) => {
+        if (!message || typeof message.type !== 'string') return;
+        if (message.type === 'metrics:snapshot') {
+            const request = requests.get(message.requestId);
+            if (!request) return;
+            request.snapshots.push(message.families);
+            if (request.snapshots.length >= request.expected) request.finish();
+            return;
+        }
+        if (message.type !== 'metrics:collect') return;
+
+        const targets = Object.values(cluster.workers).filter(target => target.isConnected());
+        const request = {
+            expected: targets.length,
+            snapshots: [],
+            finish() {
+                clearTimeout(request.timer);
+                requests.delete(message.requestId);
+                if (worker.isConnected()) {
+                    worker.send({ type: 'metrics:collected', requestId: message.requestId, snapshots: request.snapshots });
+                }
+            }
+        };
+        request.timer = setTimeout(request.finish, COLLECT_TIMEOUT_MS);
+        requests.set(message.requestId, request);
+        for (const target of targets) {
+            target.send({ type: 'metrics:snapshot', requestId: message.requestId });
+        }
+    });
+}
+
+module.exports = { Counter, Gauge, Histogram, collect, serveClusterMetrics, DEFAULT_BUCKETS };
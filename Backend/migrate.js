@@ -0,0 +1,67 @@
+const fs = require('fs');
+const path = require('path');
+const { logger } = require('./logger');
+
+const migrationsDir = path.join(__dirname, 'migrations');
+
+// Arbitrary key so concurrent backend processes apply migrations one at a time
+const MIGRATION_LOCK_ID = 3407;
+
+// Migration files are named <version>_<description>.sql and applied in version order
+async function loadMigrations() {
+    const files = await fs.promises.readdir(migrationsDir);
+    const migrations = [];
+    for (const file of files) {
+        const match = /^(\d+)_(.+)\.sql$/.exec(file);
+        if (!match) continue;
+        migrations.push({
+            version: parseInt(match[1], 10),
+            name: match[2],
+            sql: await fs.promises.readFile(path.join(migrationsDir, file), 'utf8')
+        });
+    }
+    return migrations.sort((a, b) => a.version - b.version);
+}
+
+async function runMigrations(pool) {
+    const migrations = await loadMigrations();
+    const client = await pool.connect();
+    try {
+        // Backfills and index builds may outlast DB_STATEMENT_TIMEOUT_MS, and waiting for
+        // another process's lock must not time out either
+        await client.query('SET statement_timeout = 0');
+        await client.query('SELECT pg_advisory_lock($1)', [MIGRATION_LOCK_ID]);
+        await client.query(`
+            CREATE TABLE if not exists schema_migrations (
+                version INTEGER PRIMARY KEY,
+                name VARCHAR(255) NOT NULL,
+                applied_at TIMESTAMP NOT NULL DEFAULT NOW()
+            )
+        `);
+        const applied = await client.query('SELECT version FROM schema_migrations');
+        const appliedVersions = new Set(applied.rows.map(row => row.version));
+
+        for (const migration of migrations) {
+            if (appliedVersions.has(migration.version)) continue;
+            logger.info('Applying migration', { version: migration.version, name: migration.name });
+            try {
+                await client.query('BEGIN');
+                await client.query(migration.sql);
+                await client.query(
+                    'INSERT INTO schema_migrations (version, name) VALUES ($1, $2)',
+                    [migration.version, migration.name]
+                );
+                await client.query('COMMIT');
+            } catch (error) {
+                await client.query('ROLLBACK');
+                throw new Error(`Migration ${migration.version}_${migration.name} failed: ${error.message}`);
+            }
+        }
+    } finally {
+        await client.query('SELECT pg_advisory_unlock($1)', [MIGRATION_LOCK_ID]).catch(() => {});
+        await client.query('RESET statement_timeout').catch(() => {});
+        client.release();
+    }
+}
+
+module.exports = { runMigrations };
@@ -0,0 +1,38 @@
+-- Per status/type rollup behind GET /api/claims/summary, kept current by a trigger on claims
+CREATE TABLE if not exists claim_totals (
+    status VARCHAR(20) NOT NULL,
+    type VARCHAR(50) NOT NULL,
+    claim_count INTEGER NOT NULL DEFAULT 0,
+    total_amount DECIMAL(14,2) NOT NULL DEFAULT 0,
+    PRIMARY KEY (status, type)
+);
+
+CREATE OR REPLACE FUNCTION claim_totals_apply() RETURNS trigger AS $$
+BEGIN
+    IF TG_OP IN ('UPDATE', 'DELETE') THEN
+        UPDATE claim_totals
+        SET claim_count = claim_count - 1, total_amount = total_amount - COALESCE(OLD.amount, 0)
+        WHERE status = COALESCE(OLD.status, '') AND type = COALESCE(OLD.type, '');
+    END IF;
+    IF TG_OP IN ('INSERT', 'UPDATE') THEN
+        INSERT INTO claim_totals (status, type, claim_count, total_amount)
+        VALUES (COALESCE(NEW.status, ''), COALESCE(NEW.type, ''), 1, COALESCE(NEW.amount, 0))
+        ON CONFLICT (status, type) DO UPDATE
+        SET claim_count = claim_totals.claim_count + 1,
+            total_amount = claim_totals.total_amount + EXCLUDED.total_amount;
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER if exists claims_totals_trigger ON claims;
+CREATE TRIGGER claims_totals_trigger
+    AFTER INSERT OR UPDATE OF status, type, amount OR DELETE ON claims
+    FOR EACH ROW EXECUTE FUNCTION claim_totals_apply();
+
+-- Backfill rows written before the trigger existed
+LOCK TABLE claims IN SHARE ROW EXCLUSIVE MODE;
+DELETE FROM claim_totals;
+INSERT INTO claim_totals (status, type, claim_count, total_amount)
+    SELECT COALESCE(status, ''), COALESCE(type, ''), COUNT(*), COALESCE(SUM(amount), 0)
+    FROM claims GROUP BY 1, 2;
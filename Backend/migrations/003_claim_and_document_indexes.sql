@@ -0,0 +1,11 @@
+-- HR tables: WHERE status = ANY(...) ORDER BY created_at DESC, claim_id DESC with keyset cursors
+CREATE INDEX if not exists claims_status_created_at_idx ON claims (status, created_at DESC, claim_id DESC);
+
+-- Unfiltered listing and cursor pagination across all statuses
+CREATE INDEX if not exists claims_created_at_idx ON claims (created_at DESC, claim_id DESC);
+
+-- Employee claim history
+CREATE INDEX if not exists claims_employee_id_created_at_idx ON claims (employee_id, created_at DESC);
+
+-- Document lookups per claim and the correlated json_agg in GET /api/claims
+CREATE INDEX if not exists documents_claim_id_idx ON documents (claim_id);
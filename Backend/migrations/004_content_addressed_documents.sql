@@ -0,0 +1,32 @@
+-- Uploads are stored once per SHA-256; documents reference the shared file by hash
+ALTER TABLE documents ADD COLUMN if not exists content_hash CHAR(64);
+ALTER TABLE documents ADD COLUMN if not exists size_bytes BIGINT;
+
+CREATE TABLE if not exists document_blobs (
+    content_hash CHAR(64) PRIMARY KEY,
+    file_path VARCHAR(255) NOT NULL,
+    size_bytes BIGINT,
+    ref_count INTEGER NOT NULL DEFAULT 0,
+    created_at TIMESTAMP NOT NULL DEFAULT NOW()
+);
+
+CREATE INDEX if not exists documents_content_hash_idx ON documents (content_hash);
+
+CREATE OR REPLACE FUNCTION document_blobs_apply() RETURNS trigger AS $$
+BEGIN
+    IF TG_OP IN ('UPDATE', 'DELETE') AND OLD.content_hash IS NOT NULL THEN
+        UPDATE document_blobs SET ref_count = ref_count - 1 WHERE content_hash = OLD.content_hash;
+    END IF;
+    IF TG_OP IN ('INSERT', 'UPDATE') AND NEW.content_hash IS NOT NULL THEN
+        INSERT INTO document_blobs (content_hash, file_path, size_bytes, ref_count)
+        VALUES (NEW.content_hash, NEW.file_path, NEW.size_bytes, 1)
+        ON CONFLICT (content_hash) DO UPDATE SET ref_count = document_blobs.ref_count + 1;
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER if exists documents_blobs_trigger ON documents;
+CREATE TRIGGER documents_blobs_trigger
+    AFTER INSERT OR UPDATE OF content_hash OR DELETE ON documents
+    FOR EACH ROW EXECUTE FUNCTION document_blobs_apply();
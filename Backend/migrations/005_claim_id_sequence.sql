@@ -0,0 +1,10 @@
+-- Claim IDs come from a sequence: CLM-<year>-<number zero-padded to 6 digits>. The padded form
+-- can't collide with the legacy random CLM-<year>-<4 digits> IDs. New IDs sort after one
+-- another, so inserts land on the right edge of the primary key index, but as text they sort
+-- before the legacy IDs of the same year (CLM-2025-000123 < CLM-2025-4821) until the sequence
+-- reaches 7 digits. Order claims by created_at, not claim_id.
+CREATE SEQUENCE if not exists claim_id_seq;
+
+CREATE OR REPLACE FUNCTION next_claim_id(created TIMESTAMP) RETURNS VARCHAR AS $$
+    SELECT 'CLM-' || to_char(created, 'YYYY') || '-' || lpad(nextval('claim_id_seq')::text, 6, '0');
+$$ LANGUAGE sql VOLATILE;
@@ -0,0 +1,27 @@
+-- Publishes a compact delta on the claim_changes channel for every new claim and status
+-- change. NOTIFY is transactional, so listeners only hear about committed rows.
+CREATE OR REPLACE FUNCTION claims_notify_change() RETURNS trigger AS $$
+BEGIN
+    PERFORM pg_notify('claim_changes', json_build_object(
+        'op', TG_OP,
+        'previous_status', CASE WHEN TG_OP = 'UPDATE' THEN OLD.status END,
+        'claim', json_build_object(
+            'claim_id', NEW.claim_id,
+            'type', NEW.type,
+            'employee_id', NEW.employee_id,
+            'employee_name', NEW.employee_name,
+            'amount', NEW.amount,
+            'status', NEW.status,
+            -- Same UTC ISO form node-postgres produces for these columns in API responses
+            'created_at', to_char(NEW.created_at, 'YYYY-MM-DD"T"HH24:MI:SS.MS"Z"'),
+            'updated_at', to_char(NEW.updated_at, 'YYYY-MM-DD"T"HH24:MI:SS.MS"Z"')
+        )
+    )::text);
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER if exists claims_notify_trigger ON claims;
+CREATE TRIGGER claims_notify_trigger
+    AFTER INSERT OR UPDATE OF status ON claims
+    FOR EACH ROW EXECUTE FUNCTION claims_notify_change();
@@ -0,0 +1,8 @@
+-- Delta sync (GET /api/claims/changes) walks claims by (updated_at, claim_id).
+-- Rows written before updated_at was always set get their creation time.
+UPDATE claims SET updated_at = created_at WHERE updated_at IS NULL;
+
+CREATE INDEX if not exists claims_updated_at_idx ON claims (updated_at, claim_id);
+
+-- Employee claim history syncing only its own changes
+CREATE INDEX if not exists claims_employee_id_updated_at_idx ON claims (employee_id, updated_at, claim_id);
@@ -0,0 +1,19 @@
+-- WebP thumbnails / first-page previews rendered by previews.js after a claim is submitted.
+-- A row is inserted with each document; the worker moves it to 'ready' or 'failed'.
+CREATE TABLE if not exists document_previews (
+    document_id INTEGER PRIMARY KEY REFERENCES documents(id) ON DELETE CASCADE,
+    status VARCHAR(20) NOT NULL DEFAULT 'pending',
+    file_path VARCHAR(255),
+    size_bytes INTEGER,
+    error TEXT,
+    attempts INTEGER NOT NULL DEFAULT 0,
+    updated_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP
+);
+
+-- The worker's startup sweep
+CREATE INDEX if not exists document_previews_pending_idx ON document_previews (document_id) WHERE status = 'pending';
+
+-- Documents uploaded before previews existed are rendered by that sweep too
+INSERT INTO document_previews (document_id)
+SELECT id FROM documents
+ON CONFLICT (document_id) DO NOTHING;
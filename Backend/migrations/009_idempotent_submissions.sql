@@ -0,0 +1,23 @@
+-- Claim submissions carry a client-generated Idempotency-Key; retrying the same submission
+-- returns the claim created the first time instead of a duplicate.
+ALTER TABLE claims ADD COLUMN if not exists idempotency_key VARCHAR(64);
+
+CREATE UNIQUE INDEX if not exists claims_idempotency_key_idx ON claims (idempotency_key) WHERE idempotency_key IS NOT NULL;
+
+-- Resumable document uploads (uploadSessions.js). The partial file in Uploads/.incoming is
+-- the source of truth for the offset; a row is completed once its bytes are published.
+CREATE TABLE if not exists upload_sessions (
+    id UUID PRIMARY KEY,
+    file_name VARCHAR(255) NOT NULL,
+    content_type VARCHAR(100) NOT NULL,
+    size_bytes BIGINT NOT NULL,
+    expected_hash CHAR(64),
+    content_hash CHAR(64),
+    file_path VARCHAR(255),
+    completed_at TIMESTAMP,
+    created_at TIMESTAMP NOT NULL DEFAULT NOW(),
+    expires_at TIMESTAMP NOT NULL
+);
+
+CREATE INDEX if not exists upload_sessions_expires_at_idx ON upload_sessions (expires_at);
+CREATE INDEX if not exists upload_sessions_content_hash_idx ON upload_sessions (content_hash) WHERE content_hash IS NOT NULL;
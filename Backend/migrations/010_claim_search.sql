@@ -0,0 +1,11 @@
+-- Full-text search behind GET /api/claims/search. The 'simple' configuration keeps names
+-- and department codes unstemmed, so prefix queries built from what HR types match them
+-- as written. Weights rank a hit in the employee name above one in the description.
+-- Adding a stored generated column rewrites the table once.
+ALTER TABLE claims ADD COLUMN if not exists search_vector tsvector GENERATED ALWAYS AS (
+    setweight(to_tsvector('simple', coalesce(employee_name, '')), 'A')
+    || setweight(to_tsvector('simple', coalesce(description, '')), 'B')
+    || setweight(to_tsvector('simple', coalesce(department, '') || ' ' || coalesce(type, '')), 'C')
+) STORED;
+
+CREATE INDEX if not exists claims_search_vector_idx ON claims USING GIN (search_vector);
@@ -0,0 +1,169 @@
+-- claims becomes a declaratively partitioned table, one range partition per created_at month
+-- (claims_YYYY_MM) plus claims_default for stamps no partition covers. The ORDER BY
+-- created_at DESC listings read the newest partitions first and stop at their LIMIT.
+-- archiver.js keeps partitions created ahead of time, moves claims finalized more than
+-- ARCHIVE_AFTER_MONTHS ago into claims_archive / documents_archive and drops old
+-- partitions once that has emptied them. Until then, lookups by claim_id alone probe every
+-- partition's primary key.
+--
+-- Unique constraints on a partitioned table must include the partition key, so:
+--   * the primary key becomes (claim_id, created_at); next_claim_id() keeps claim_id unique
+--   * Idempotency-Key uniqueness moves to claim_idempotency_keys, kept by a trigger
+--   * documents.claim_id can no longer reference claims; a trigger deletes a claim's
+--     documents with it in place of ON DELETE CASCADE
+LOCK TABLE claims IN ACCESS EXCLUSIVE MODE;
+
+-- Creates the missing monthly partitions for every month from `from_month` through `through`.
+-- Fails if claims_default already holds rows for one of those months.
+CREATE OR REPLACE FUNCTION create_claim_partitions(from_month TIMESTAMP, through TIMESTAMP) RETURNS INTEGER AS $$
+DECLARE
+    month_start TIMESTAMP := date_trunc('month', from_month);
+    partition_name TEXT;
+    created INTEGER := 0;
+BEGIN
+    WHILE month_start <= through LOOP
+        partition_name := 'claims_' || to_char(month_start, 'YYYY_MM');
+        IF to_regclass(partition_name) IS NULL THEN
+            EXECUTE format('CREATE TABLE %I PARTITION OF claims FOR VALUES FROM (%L) TO (%L)',
+                partition_name, month_start, month_start + interval '1 month');
+            created := created + 1;
+        END IF;
+        month_start := month_start + interval '1 month';
+    END LOOP;
+    RETURN created;
+END;
+$$ LANGUAGE plpgsql;
+
+ALTER TABLE claims RENAME TO claims_unpartitioned;
+ALTER INDEX if exists claims_pkey RENAME TO claims_unpartitioned_pkey;
+
+CREATE TABLE claims (
+    claim_id VARCHAR(20) NOT NULL,
+    employee_name VARCHAR(100),
+    employee_email VARCHAR(100),
+    employee_id VARCHAR(10),
+    department VARCHAR(50),
+    claim_date DATE,
+    amount DECIMAL(10,2),
+    description TEXT,
+    type VARCHAR(50),
+    status VARCHAR(20),
+    created_at TIMESTAMP NOT NULL,
+    updated_at TIMESTAMP,
+    idempotency_key VARCHAR(64),
+    -- Same expression as 010_claim_search.sql
+    search_vector tsvector GENERATED ALWAYS AS (
+        setweight(to_tsvector('simple', coalesce(employee_name, '')), 'A')
+        || setweight(to_tsvector('simple', coalesce(description, '')), 'B')
+        || setweight(to_tsvector('simple', coalesce(department, '') || ' ' || coalesce(type, '')), 'C')
+    ) STORED,
+    PRIMARY KEY (claim_id, created_at)
+) PARTITION BY RANGE (created_at);
+
+CREATE TABLE claims_default PARTITION OF claims DEFAULT;
+
+-- Rows from before created_at was always set get the best timestamp they have
+SELECT create_claim_partitions(
+    COALESCE((SELECT min(COALESCE(created_at, updated_at, claim_date::timestamp)) FROM claims_unpartitioned), now()::timestamp),
+    now()::timestamp + interval '3 months'
+);
+
+INSERT INTO claims (claim_id, employee_name, employee_email, employee_id, department, claim_date,
+                    amount, description, type, status, created_at, updated_at, idempotency_key)
+SELECT claim_id, employee_name, employee_email, employee_id, department, claim_date,
+       amount, description, type, status, COALESCE(created_at, updated_at, claim_date::timestamp, now()::timestamp),
+       updated_at, idempotency_key
+FROM claims_unpartitioned;
+
+-- Also drops documents' foreign key and the old table's indexes and triggers
+DROP TABLE claims_unpartitioned CASCADE;
+
+CREATE INDEX claims_status_created_at_idx ON claims (status, created_at DESC, claim_id DESC);
+CREATE INDEX claims_created_at_idx ON claims (created_at DESC, claim_id DESC);
+CREATE INDEX claims_employee_id_created_at_idx ON claims (employee_id, created_at DESC);
+CREATE INDEX claims_updated_at_idx ON claims (updated_at, claim_id);
+CREATE INDEX claims_employee_id_updated_at_idx ON claims (employee_id, updated_at, claim_id);
+CREATE INDEX claims_search_vector_idx ON claims USING GIN (search_vector);
+
+-- The rows were copied before these existed, so claim_totals is still correct
+CREATE TRIGGER claims_totals_trigger
+    AFTER INSERT OR UPDATE OF status, type, amount OR DELETE ON claims
+    FOR EACH ROW EXECUTE FUNCTION claim_totals_apply();
+
+CREATE TRIGGER claims_notify_trigger
+    AFTER INSERT OR UPDATE OF status ON claims
+    FOR EACH ROW EXECUTE FUNCTION claims_notify_change();
+
+-- A second insert with the same key fails on this table's primary key, which aborts the
+-- claim INSERT too
+CREATE TABLE if not exists claim_idempotency_keys (
+    idempotency_key VARCHAR(64) PRIMARY KEY,
+    claim_id VARCHAR(20) NOT NULL
+);
+
+INSERT INTO claim_idempotency_keys (idempotency_key, claim_id)
+SELECT idempotency_key, claim_id FROM claims WHERE idempotency_key IS NOT NULL;
+
+CREATE OR REPLACE FUNCTION claims_idempotency_apply() RETURNS trigger AS $$
+BEGIN
+    IF TG_OP = 'INSERT' THEN
+        INSERT INTO claim_idempotency_keys (idempotency_key, claim_id) VALUES (NEW.idempotency_key, NEW.claim_id);
+    ELSE
+        DELETE FROM claim_idempotency_keys WHERE idempotency_key = OLD.idempotency_key;
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER claims_idempotency_insert_trigger
+    AFTER INSERT ON claims
+    FOR EACH ROW WHEN (NEW.idempotency_key IS NOT NULL) EXECUTE FUNCTION claims_idempotency_apply();
+
+CREATE TRIGGER claims_idempotency_delete_trigger
+    AFTER DELETE ON claims
+    FOR EACH ROW WHEN (OLD.idempotency_key IS NOT NULL) EXECUTE FUNCTION claims_idempotency_apply();
+
+CREATE OR REPLACE FUNCTION claims_delete_documents() RETURNS trigger AS $$
+BEGIN
+    DELETE FROM documents WHERE claim_id = OLD.claim_id;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER claims_documents_trigger
+    AFTER DELETE ON claims
+    FOR EACH ROW EXECUTE FUNCTION claims_delete_documents();
+
+-- Archive tier: approved and rejected claims past ARCHIVE_AFTER_MONTHS, still served by ID.
+-- Their files move to cold storage (DOCUMENT_ARCHIVE_DIR) once no live document shares them.
+CREATE TABLE if not exists claims_archive (
+    claim_id VARCHAR(20) PRIMARY KEY,
+    employee_name VARCHAR(100),
+    employee_email VARCHAR(100),
+    employee_id VARCHAR(10),
+    department VARCHAR(50),
+    claim_date DATE,
+    amount DECIMAL(10,2),
+    description TEXT,
+    type VARCHAR(50),
+    status VARCHAR(20),
+    created_at TIMESTAMP NOT NULL,
+    updated_at TIMESTAMP,
+    idempotency_key VARCHAR(64),
+    archived_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP
+);
+
+CREATE INDEX if not exists claims_archive_employee_id_idx ON claims_archive (employee_id, created_at DESC);
+
+CREATE TABLE if not exists documents_archive (
+    id INTEGER PRIMARY KEY,
+    claim_id VARCHAR(20) NOT NULL REFERENCES claims_archive(claim_id) ON DELETE CASCADE,
+    file_name VARCHAR(255),
+    file_path VARCHAR(255),
+    uploaded_at TIMESTAMP,
+    content_hash CHAR(64),
+    size_bytes BIGINT
+);
+
+CREATE INDEX if not exists documents_archive_claim_id_idx ON documents_archive (claim_id);
+CREATE INDEX if not exists documents_archive_file_path_idx ON documents_archive (file_path);
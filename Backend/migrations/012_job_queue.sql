@@ -0,0 +1,40 @@
+-- Durable queue for work that runs after a request has been answered (jobs.js). A job is
+-- enqueued in the same transaction as the rows it is about, is claimed by one worker with
+-- FOR UPDATE SKIP LOCKED and deleted once its handler succeeds. locked_until is the claim's
+-- lease: a job whose worker died becomes claimable again when it passes. Failed attempts are
+-- retried at run_at with backoff; after max_attempts the job moves to job_dead_letters.
+CREATE TABLE if not exists jobs (
+    id BIGSERIAL PRIMARY KEY,
+    kind VARCHAR(50) NOT NULL,
+    payload JSONB NOT NULL DEFAULT '{}',
+    run_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    locked_until TIMESTAMP,
+    attempts INTEGER NOT NULL DEFAULT 0,
+    max_attempts INTEGER NOT NULL DEFAULT 5,
+    last_error TEXT,
+    created_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP
+);
+
+-- The claim query: due jobs of one kind, oldest first
+CREATE INDEX if not exists jobs_kind_run_at_idx ON jobs (kind, run_at, id);
+
+-- Kept for inspection. To retry one:
+--   INSERT INTO jobs (kind, payload) SELECT kind, payload FROM job_dead_letters WHERE id = ...;
+CREATE TABLE if not exists job_dead_letters (
+    id BIGINT PRIMARY KEY,
+    kind VARCHAR(50) NOT NULL,
+    payload JSONB NOT NULL,
+    attempts INTEGER NOT NULL,
+    last_error TEXT,
+    created_at TIMESTAMP NOT NULL,
+    failed_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP
+);
+
+CREATE INDEX if not exists job_dead_letters_kind_failed_at_idx ON job_dead_letters (kind, failed_at DESC);
+
+-- Previews still waiting on the old in-process queue and its startup sweep
+INSERT INTO jobs (kind, payload, max_attempts)
+SELECT 'document_preview', jsonb_build_object('documentId', document_id), 3
+FROM document_previews WHERE status = 'pending';
+
+DROP INDEX if exists document_previews_pending_idx;
@@ -0,0 +1,15 @@
+-- claim_totals counts archived claims too, so the summary dashboard's totals don't shrink
+-- as archiver.js moves finalized claims to claims_archive. Deleting an archived claim from
+-- claims still runs the totals trigger; archiveBatch adds the claims back in the same
+-- transaction. Rebuild the rows that earlier archival runs decremented.
+LOCK TABLE claims IN SHARE ROW EXCLUSIVE MODE;
+LOCK TABLE claims_archive IN SHARE ROW EXCLUSIVE MODE;
+DELETE FROM claim_totals;
+INSERT INTO claim_totals (status, type, claim_count, total_amount)
+    SELECT COALESCE(status, ''), COALESCE(type, ''), COUNT(*), COALESCE(SUM(amount), 0)
+    FROM (
+        SELECT status, type, amount FROM claims
+        UNION ALL
+        SELECT status, type, amount FROM claims_archive
+    ) AS all_claims
+    GROUP BY 1, 2;
@@ -0,0 +1,86 @@
+-- claim_totals is kept by statement-level triggers instead of the per-row claim_totals_apply().
+-- The row trigger locked the old and then the new (status, type) row in whatever order a
+-- statement visited its claims, so two decisions going opposite ways (approved -> rejected
+-- and rejected -> approved, or bulk batches visiting Travel and Medical claims in opposite
+-- orders) could deadlock. Now each statement sums its changes per (status, type) from the
+-- transition tables and upserts them in sorted key order.
+--
+-- Each (status, type) is also split over 16 shard rows, and a transaction writes only to the
+-- shard picked by its transaction ID (claim_totals_shard()). Submissions of one type no
+-- longer queue on a single row held by a long decision batch, and since a transaction only
+-- ever locks rows of its own shard, in key order, transactions can't deadlock on
+-- claim_totals. Readers sum over the shards; a shard's count may go negative, the sum can't.
+LOCK TABLE claims IN SHARE ROW EXCLUSIVE MODE;
+
+DROP TRIGGER if exists claims_totals_trigger ON claims;
+DROP FUNCTION if exists claim_totals_apply();
+
+ALTER TABLE claim_totals ADD COLUMN if not exists shard SMALLINT NOT NULL DEFAULT 0;
+ALTER TABLE claim_totals DROP CONSTRAINT claim_totals_pkey;
+ALTER TABLE claim_totals ADD PRIMARY KEY (status, type, shard);
+
+-- The claim_totals shard the current transaction writes to
+CREATE OR REPLACE FUNCTION claim_totals_shard() RETURNS SMALLINT AS $$
+    SELECT (txid_current() % 16)::smallint;
+$$ LANGUAGE sql VOLATILE;
+
+CREATE OR REPLACE FUNCTION claim_totals_apply_changes() RETURNS trigger AS $$
+DECLARE
+    target_shard SMALLINT := claim_totals_shard();
+BEGIN
+    IF TG_OP = 'INSERT' THEN
+        INSERT INTO claim_totals (status, type, shard, claim_count, total_amount)
+        SELECT COALESCE(status, ''), COALESCE(type, ''), target_shard, COUNT(*), COALESCE(SUM(amount), 0)
+        FROM new_claims
+        GROUP BY 1, 2
+        ORDER BY 1, 2
+        ON CONFLICT (status, type, shard) DO UPDATE
+        SET claim_count = claim_totals.claim_count + EXCLUDED.claim_count,
+            total_amount = claim_totals.total_amount + EXCLUDED.total_amount;
+    ELSIF TG_OP = 'DELETE' THEN
+        INSERT INTO claim_totals (status, type, shard, claim_count, total_amount)
+        SELECT COALESCE(status, ''), COALESCE(type, ''), target_shard, -COUNT(*), -COALESCE(SUM(amount), 0)
+        FROM old_claims
+        GROUP BY 1, 2
+        ORDER BY 1, 2
+        ON CONFLICT (status, type, shard) DO UPDATE
+        SET claim_count = claim_totals.claim_count + EXCLUDED.claim_count,
+            total_amount = claim_totals.total_amount + EXCLUDED.total_amount;
+    ELSE
+        -- Updates that leave status, type and amount alone cancel out and touch no row
+        INSERT INTO claim_totals (status, type, shard, claim_count, total_amount)
+        SELECT status, type, target_shard, SUM(delta), SUM(amount)
+        FROM (
+            SELECT COALESCE(status, '') AS status, COALESCE(type, '') AS type, -1 AS delta, -COALESCE(amount, 0) AS amount
+            FROM old_claims
+            UNION ALL
+            SELECT COALESCE(status, ''), COALESCE(type, ''), 1, COALESCE(amount, 0)
+            FROM new_claims
+        ) AS changes
+        GROUP BY 1, 2
+        HAVING SUM(delta) <> 0 OR SUM(amount) <> 0
+        ORDER BY 1, 2
+        ON CONFLICT (status, type, shard) DO UPDATE
+        SET claim_count = claim_totals.claim_count + EXCLUDED.claim_count,
+            total_amount = claim_totals.total_amount + EXCLUDED.total_amount;
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Transition tables can't be combined with UPDATE OF <columns>, so the update trigger fires on
+-- every update and relies on unchanged rows cancelling out
+CREATE TRIGGER claims_totals_insert_trigger
+    AFTER INSERT ON claims
+    REFERENCING NEW TABLE AS new_claims
+    FOR EACH STATEMENT EXECUTE FUNCTION claim_totals_apply_changes();
+
+CREATE TRIGGER claims_totals_update_trigger
+    AFTER UPDATE ON claims
+    REFERENCING OLD TABLE AS old_claims NEW TABLE AS new_claims
+    FOR EACH STATEMENT EXECUTE FUNCTION claim_totals_apply_changes();
+
+CREATE TRIGGER claims_totals_delete_trigger
+    AFTER DELETE ON claims
+    REFERENCING OLD TABLE AS old_claims
+    FOR EACH STATEMENT EXECUTE FUNCTION claim_totals_apply_changes();
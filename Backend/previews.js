@@ -0,0 +1,131 @@
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const crypto = require('crypto');
+const { execFile } = require('child_process');
+const { promisify } = require('util');
+const { logger } = require('./logger');
+
+const execFileAsync = promisify(execFile);
+
+const TOOL_TIMEOUT_MS = 30000;
+const MAX_ATTEMPTS = 3;
+const PREVIEW_JOB = 'document_preview';
+
+// Generates small WebP previews for uploaded documents: thumbnails of JPG/PNG images and a
+// raster of a PDF's first page. Rows in document_previews are created with the documents
+// (status 'pending') together with a document_preview job each (see jobs.js); the job turns
+// them into 'ready' or 'failed'. Failed renders are retried by the queue, with backoff.
+//
+// The image work runs in child processes (libvips' vipsthumbnail, poppler's pdftoppm), so the
+// event loop only waits on I/O. Previews are named by content hash, so identical uploads
+// share one file.
+class PreviewWorker {
+    constructor({ pool, jobs, storage, directory, concurrency = 2, size = 320 }) {
+        this.pool = pool;
+        this.jobs = jobs;
+        this.storage = storage;
+        this.directory = directory;
+        this.concurrency = concurrency;
+        this.size = size;
+    }
+
+    // Takes preview jobs from the queue once the tools are known to be installed
+    async start() {
+        try {
+            await execFileAsync('vipsthumbnail', ['--vips-version'], { timeout: TOOL_TIMEOUT_MS });
+        } catch (error) {
+            // The jobs stay queued and run once a process with the tools is started
+            logger.warn('Document previews disabled: vipsthumbnail is not available', { error });
+            return;
+        }
+        await fs.promises.mkdir(this.directory, { recursive: true });
+        this.jobs.register(PREVIEW_JOB, (payload, job) => this.process(payload.documentId, job), {
+            concurrency: this.concurrency,
+            backoffMs: 2000
+        });
+    }
+
+    // Queues a preview of each document; `db` is the transaction that inserted them
+    enqueue(db, documentIds) {
+        return this.jobs.enqueue(db, PREVIEW_JOB, documentIds.map(documentId => ({ documentId })), { maxAttempts: MAX_ATTEMPTS });
+    }
+
+    async process(documentId, job) {
+        const result = await this.pool.query(
+            `SELECT d.file_path, d.file_name, d.content_hash
+             FROM document_previews p JOIN documents d ON d.id = p.document_id
+             WHERE p.document_id = $1 AND p.status = 'pending'`,
+            [documentId]
+        );
+        if (result.rows.length === 0) return;
+        const doc = result.rows[0];
+
+        const ext = path.extname(doc.file_name || doc.file_path).toLowerCase();
+        const kind = ext === '.pdf' ? 'pdf' : ['.jpg', '.jpeg', '.png'].includes(ext) ? 'image' : null;
+        if (!kind) {
+            return this.finish(documentId, { status: 'failed', error: `No preview for ${ext || 'unknown'} files` });
+        }
+
+        const name = doc.content_hash ? doc.content_hash.trim() : `document-${documentId}`;
+        const previewPath = path.join(this.directory, `${name}.webp`);
+        const start = Date.now();
+        try {
+            let stat = await fs.promises.stat(previewPath).catch(() => null);
+            if (!stat) {
+                await this.storage.forPath(doc.file_path).withLocalFile(doc.file_path, source =>
+                    this.render(kind, source, previewPath));
+                stat = await fs.promises.stat(previewPath);
+            }
+            await this.finish(documentId, { status: 'ready', filePath: previewPath, size: stat.size });
+            logger.debug('Document preview ready', { documentId, kind, bytes: stat.size, durationMs: Date.now() - start });
+        } catch (error) {
+            const { attempts } = job;
+            if (attempts >= job.maxAttempts) {
+                await this.finish(documentId, { status: 'failed', error: error.message, attempts });
+            } else {
+                await this.pool.query(
+                    'UPDATE document_previews SET attempts = $2, updated_at = $3 WHERE document_id = $1',
+                    [documentId, attempts, new Date()]
+                );
+            }
+            // The queue retries the job, or dead-letters it after the last attempt
+            throw error;
+        }
+    }
+
+    // Writes to a temp name and renames, so concurrent workers never serve a partial file
+    async render(kind, source, previewPath) {
+        const tempBase = path.join(os.tmpdir(), `preview-${crypto.randomUUID()}`);
+        const tempOutput = `${previewPath}.${crypto.randomUUID()}.tmp.webp`;
+        let input = source;
+        try {
+            if (kind === 'pdf') {
+                await execFileAsync('pdftoppm', [
+                    '-f', '1', '-l', '1', '-singlefile', '-png', '-scale-to', String(this.size * 2), source, tempBase
+                ], { timeout: TOOL_TIMEOUT_MS });
+                input = `${tempBase}.png`;
+            }
+            await execFileAsync('vipsthumbnail', [
+                input, '--size', `${this.size}x${this.size}`, '-o', `${tempOutput}[Q=60,strip]`
+            ], { timeout: TOOL_TIMEOUT_MS });
+            await fs.promises.rename(tempOutput, previewPath);
+        } finally {
+            await fs.promises.unlink(tempOutput).catch(() => {});
+            if (input !== source) {
+                await fs.promises.unlink(input).catch(() => {});
+            }
+        }
+    }
+
+    async finish(documentId, { status, filePath = null, size = null, error = null, attempts }) {
+        await this.pool.query(
+            `UPDATE document_previews
+             SET status = $2, file_path = $3, size_bytes = $4, error = $5, attempts = COALESCE($6, attempts), updated_at = $7
+             WHERE document_id = $1`,
+            [documentId, status, filePath, size, error, attempts === undefined ? null : attempts, new Date()]
+        );
+    }
+}
+
+module.exports = { PreviewWorker };
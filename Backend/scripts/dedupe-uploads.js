@@ -0,0 +1,73 @@
+// One-off backfill: moves documents uploaded before content addressing onto
+// <sha256><ext> files and deletes the duplicate copies.
+//   node scripts/dedupe-uploads.js [--dry-run]
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+const { pool } = require('../db');
+const { logger } = require('../logger');
+
+const dryRun = process.argv.includes('--dry-run');
+
+function hashFile(filePath) {
+    return new Promise((resolve, reject) => {
+        const hash = crypto.createHash('sha256');
+        fs.createReadStream(filePath)
+            .on('error', reject)
+            .on('data', chunk => hash.update(chunk))
+            .on('end', () => resolve(hash.digest('hex')));
+    });
+}
+
+async function main() {
+    const result = await pool.query(
+        'SELECT id, file_path FROM documents WHERE content_hash IS NULL ORDER BY id'
+    );
+    let reclaimedBytes = 0;
+    let migrated = 0;
+
+    for (const doc of result.rows) {
+        let stat;
+        try {
+            stat = await fs.promises.stat(doc.file_path);
+        } catch (error) {
+            logger.warn('Skipping document with missing file', { documentId: doc.id, path: doc.file_path });
+            continue;
+        }
+
+        const contentHash = await hashFile(doc.file_path);
+        const finalPath = path.join(path.dirname(doc.file_path), contentHash + path.extname(doc.file_path).toLowerCase());
+        if (dryRun) {
+            logger.info('Would migrate document', { documentId: doc.id, from: doc.file_path, to: finalPath });
+            continue;
+        }
+
+        let duplicate = false;
+        if (finalPath !== doc.file_path) {
+            try {
+                await fs.promises.link(doc.file_path, finalPath);
+            } catch (error) {
+                if (error.code !== 'EEXIST') throw error;
+                duplicate = true;
+            }
+        }
+        await pool.query(
+            'UPDATE documents SET file_path = $1, content_hash = $2, size_bytes = $3 WHERE id = $4',
+            [finalPath, contentHash, stat.size, doc.id]
+        );
+        if (finalPath !== doc.file_path) {
+            await fs.promises.unlink(doc.file_path).catch(() => {});
+        }
+        if (duplicate) reclaimedBytes += stat.size;
+        migrated++;
+    }
+
+    logger.info('Upload deduplication finished', { migrated, reclaimedBytes, dryRun });
+}
+
+main()
+    .catch(error => {
+        logger.error('Upload deduplication failed', { error });
+        process.exitCode = 1;
+    })
+    .finally(() => pool.end());
@@ -1,149 +1,566 @@
 const express = require('express');
-const { Pool } = require('pg');
 const cors = require('cors');
 const multer = require('multer');
 const path = require('path');
 const fs = require('fs');
+const { runMigrations } = require('./migrate');
+const { logger, requestLogger } = require('./logger');
+const { compressJson } = require('./compression');
+const { pool, readPool, prepared, withTransaction, startReplicaMonitor, closePools } = require('./db');
+const { createStorage } = require('./storage');
+const { IMMUTABLE_MAX_AGE } = require('./storage/local');
+const { changeFeed } = require('./changeFeed');
+const { PreviewWorker } = require('./previews');
+const { JobQueue } = require('./jobs');
+const { ClaimArchiver } = require('./archiver');
+const { streamClaimExport, FORMATS: EXPORT_FORMATS } = require('./claimExport');
+const { UploadSessions, UploadError } = require('./uploadSessions');
+const metrics = require('./metrics');
 
 const app = express();
+
+// Set once migrations have run; shuttingDown makes readiness fail so traffic moves elsewhere
+// while in-flight requests drain
+let ready = false;
+let shuttingDown = false;
+const READINESS_DB_TIMEOUT_MS = 2000;
+const SHUTDOWN_TIMEOUT_MS = Number(process.env.SHUTDOWN_TIMEOUT_MS) || 30000;
+// Under cluster.js only worker 0 runs the once-per-deployment background jobs
+const RUNS_BACKGROUND_JOBS = (process.env.WORKER_INDEX || '0') === '0';
+
+// Health probes sit ahead of the request logger so polling doesn't fill the logs.
+// GET /healthz: the process is up and its event loop responds
+app.get('/healthz', (req, res) => {
+    res.set('Cache-Control', 'no-store');
+    res.json({ status: 'ok', pid: process.pid });
+});
+
+// GET /readyz: migrations are applied, the database answers, and no shutdown is under way
+app.get('/readyz', async (req, res) => {
+    res.set('Cache-Control', 'no-store');
+    if (!ready || shuttingDown) {
+        return res.status(503).json({ status: shuttingDown ? 'shutting down' : 'starting' });
+    }
+    let timer;
+    try {
+        await Promise.race([
+            pool.query('SELECT 1'),
+            new Promise((resolve, reject) => {
+                timer = setTimeout(() => reject(new Error('Database check timed out')), READINESS_DB_TIMEOUT_MS);
+            })
+        ]);
+        res.json({ status: 'ready' });
+    } catch (error) {
+        logger.warn('Readiness check failed', { error });
+        res.status(503).json({ status: 'database unavailable' });
+    } finally {
+        clearTimeout(timer);
+    }
+});
+
+// GET /metrics: Prometheus text format covering every worker (see metrics.js)
+app.get('/metrics', async (req, res) => {
+    try {
+        res.set({ 'Content-Type': 'text/plain; version=0.0.4; charset=utf-8', 'Cache-Control': 'no-store' });
+        res.send(await metrics.collect());
+    } catch (error) {
+        logger.error('Error collecting metrics', { error });
+        res.status(500).send('Error collecting metrics\n');
+    }
+});
+
+const httpRequests = new metrics.Counter('http_requests_total', 'Requests by route and status', ['method', 'route', 'status']);
+const httpDuration = new metrics.Histogram('http_request_duration_seconds', 'Time until the response was finished', ['method', 'route']);
+
+// Routes are labelled by their Express pattern (/api/claims/:claimId), so IDs don't create
+// new series; requests that no route matched share one label
+function metricsMiddleware(req, res, next) {
+    const start = process.hrtime.bigint();
+    res.on('finish', () => {
+        const route = req.route ? req.baseUrl + req.route.path : 'unmatched';
+        httpRequests.inc({ method: req.method, route, status: res.statusCode });
+        httpDuration.observe({ method: req.method, route }, Number(process.hrtime.bigint() - start) / 1e9);
+    });
+    next();
+}
+
+app.use(requestLogger);
+app.use(metricsMiddleware);
+// While draining, each keep-alive connection is closed after its current response
+app.use((req, res, next) => {
+    if (shuttingDown) {
+        res.set('Connection', 'close');
+    }
+    next();
+});
+app.use(compressJson);
 app.use(cors());
 
 // Configure CORS
 app.use((req, res, next) => {
     res.header('Access-Control-Allow-Origin', req.headers.origin || '*');
-    res.header('Access-Control-Allow-Methods', 'GET, POST, PATCH, OPTIONS');
-    res.header('Access-Control-Allow-Headers', 'Content-Type, Accept');
+    res.header('Access-Control-Allow-Methods', 'GET, HEAD, POST, PATCH, OPTIONS');
+    res.header('Access-Control-Allow-Headers', 'Content-Type, Accept, X-Request-Id, Range, If-None-Match, If-Range, Idempotency-Key, Upload-Offset, Upload-Length');
     res.header('Access-Control-Allow-Credentials', 'true');
+    res.header('Access-Control-Expose-Headers', 'X-Next-Cursor, X-High-Water-Mark, X-Request-Id, ETag, Content-Range, Accept-Ranges, Content-Disposition, Upload-Offset, Location, Idempotent-Replayed');
     res.header('Access-Control-Max-Age', '86400');
-    console.log(`Setting CORS headers for ${req.method} ${req.path}`);
-    console.log('Response headers:', res.getHeaders());
     next();
 });
 
-// Log OPTIONS requests
 app.options('*', (req, res) => {
-    console.log('Received OPTIONS request at', new Date().toISOString());
-    console.log('Request headers:', req.headers);
     res.status(204).send();
 });
 
 app.use(express.json());
-app.use('/uploads', express.static(path.join(__dirname, 'Uploads')));
+// Upload file names never get reused, so clients may cache them indefinitely
+app.use('/uploads', express.static(path.join(__dirname, 'Uploads'), {
+    maxAge: IMMUTABLE_MAX_AGE,
+    immutable: true
+}));
 
 // Ensure uploads directory exists
 const uploadsDir = path.join(__dirname, 'Uploads');
 if (!fs.existsSync(uploadsDir)) {
-    fs.mkdirSync(UploadsDir, { recursive: true });
+    fs.mkdirSync(uploadsDir, { recursive: true });
 }
 
-// PostgreSQL connection
-const pool = new Pool({
-    user: 'postgres',
-    host: 'postgres',
-    database: 'new_employee_db',
-    password: 'admin123', 
-    port: 5432
+// Document storage: local disk, or an S3-compatible bucket with presigned browser uploads
+const storage = createStorage({ uploadsDir });
+
+// Follow-up work of requests, run in the background by every worker process
+const jobs = new JobQueue({
+    pool,
+    concurrency: Number(process.env.JOB_CONCURRENCY) || 4,
+    pollIntervalMs: Number(process.env.JOB_POLL_INTERVAL_MS) || 1000,
+    leaseMs: Number(process.env.JOB_LEASE_MS) || 5 * 60 * 1000
 });
 
-// Multer configuration
-const storage = multer.diskStorage({
-    destination: (req, file, cb) => {
-        cb(null, uploadsDir);
-    },
-    filename: (req, file, cb) => {
-        const uniqueSuffix = Date.now() + '-' + Math.round(Math.random() * 1E9);
-        const ext = path.extname(file.originalname);
-        cb(null, file.fieldname + '-' + uniqueSuffix + ext);
-    }
+// Thumbnails and PDF first-page previews, rendered by queued jobs after claims are submitted
+const previews = new PreviewWorker({
+    pool,
+    jobs,
+    storage,
+    directory: path.join(uploadsDir, 'previews'),
+    concurrency: Number(process.env.PREVIEW_CONCURRENCY) || 2
 });
 
-const upload = multer({
+// Moves claims finalized more than ARCHIVE_AFTER_MONTHS ago (0 disables) to the archive
+// tables and their files to DOCUMENT_ARCHIVE_DIR; also maintains the monthly partitions
+const archiveAfterMonths = Number(process.env.ARCHIVE_AFTER_MONTHS);
+const archiver = new ClaimArchiver({
+    pool,
     storage,
+    coldDirectory: process.env.DOCUMENT_ARCHIVE_DIR || path.join(__dirname, 'Archive'),
+    previewsDirectory: path.join(uploadsDir, 'previews'),
+    afterMonths: process.env.ARCHIVE_AFTER_MONTHS && !isNaN(archiveAfterMonths) ? archiveAfterMonths : 12,
+    batchSize: Number(process.env.ARCHIVE_BATCH_SIZE) || 500
+});
+
+const ALLOWED_DOCUMENT_TYPES = ['application/pdf', 'image/jpeg', 'image/png'];
+const MAX_DOCUMENT_SIZE = 5 * 1024 * 1024; // 5MB limit
+const MAX_DOCUMENTS_PER_CLAIM = 5;
+// Total document bytes per claim, by claim type. These leave room for several receipts or
+// scanned reports, more when the employee has the portal compress photos before upload;
+// Frontend/index.html mirrors them.
+const CLAIM_TYPE_UPLOAD_LIMITS = {
+    Medical: 20 * 1024 * 1024,
+    Travel: 15 * 1024 * 1024,
+    Education: 10 * 1024 * 1024,
+    Meal: 5 * 1024 * 1024,
+    Equipment: 10 * 1024 * 1024,
+    Other: 10 * 1024 * 1024
+};
+// Client-generated key that makes retrying a claim submission safe
+const IDEMPOTENCY_KEY_PATTERN = /^[A-Za-z0-9_-]{8,64}$/;
+const CLAIM_BY_IDEMPOTENCY_KEY = 'SELECT claim_id FROM claim_idempotency_keys WHERE idempotency_key = $1';
+
+// Resumable chunked uploads into local storage, for connections that drop mid-upload
+const uploadSessions = new UploadSessions({
+    pool,
+    storage: storage.local,
+    allowedTypes: ALLOWED_DOCUMENT_TYPES,
+    maxSize: MAX_DOCUMENT_SIZE
+});
+
+// Multer configuration: uploads that pass through this process are hashed while
+// streaming and stored once per content on local disk
+const upload = multer({
+    storage: storage.local.multerEngine,
     fileFilter: (req, file, cb) => {
-        const allowedTypes = ['application/pdf', 'image/jpeg', 'image/png'];
-        if (allowedTypes.includes(file.mimetype)) {
+        if (ALLOWED_DOCUMENT_TYPES.includes(file.mimetype)) {
             cb(null, true);
         } else {
             cb(new Error('Only PDF, JPG, and PNG files are allowed'));
         }
     },
     limits: {
-        fileSize: 5 * 1024 * 1024 // 5MB limit
+        fileSize: MAX_DOCUMENT_SIZE
     }
 });
 
+const CLAIM_STATUSES = ['pending', 'approved', 'rejected'];
+// Columns a listing may project with ?fields=
+const CLAIM_COLUMNS = [
+    'claim_id', 'employee_name', 'employee_email', 'employee_id', 'department', 'claim_date',
+    'amount', 'description', 'type', 'status', 'created_at', 'updated_at'
+];
+// Columns of a full claim in responses; search_vector stays in the database
+const CLAIM_ROW = [...CLAIM_COLUMNS, 'idempotency_key'].map(column => `claims.${column}`).join(', ');
+const MAX_PAGE_SIZE = 500;
+const SEARCH_PAGE_SIZE = 50;
+const MAX_SEARCH_OFFSET = 10000;
+const MAX_SEARCH_TERMS = 10;
+// Lower bounds of the amount facet's buckets after the first; the last bucket is open-ended
+const AMOUNT_FACET_BOUNDS = [1000, 5000, 10000, 25000];
+const MAX_BULK_CLAIMS = 500;
+// A bulk decision aborted as a deadlock victim is run again this many times before failing
+const BULK_DEADLOCK_RETRIES = 3;
+// updated_at is stamped before commit, so a write may become visible up to one transaction
+// later than its timestamp; high-water marks trail the clock by this much
+const CHANGES_SETTLE_MS = 5000;
+
+// Keyset pagination cursors: opaque base64url of "<timestamp ms>|<claim_id>", where the
+// timestamp is created_at for listings and updated_at for GET /api/claims/changes
+function encodeCursor(claim, column = 'created_at') {
+    return Buffer.from(`${new Date(claim[column]).getTime()}|${claim.claim_id}`).toString('base64url');
+}
+
+function settledHighWaterMark() {
+    return new Date(Date.now() - CHANGES_SETTLE_MS);
+}
+
+// SELECT list for ?fields=, or every claim column. claim_id and created_at are always
+// included since cursors and the default ordering are built from them.
+function claimProjection(fields) {
+    if (!fields) return { projection: CLAIM_ROW };
+    const requested = fields.split(',').map(s => s.trim()).filter(Boolean);
+    const unknown = requested.filter(field => !CLAIM_COLUMNS.includes(field));
+    if (unknown.length > 0) {
+        return { error: `Unknown fields: ${unknown.join(', ')}` };
+    }
+    return { projection: [...new Set(['claim_id', 'created_at', ...requested])].map(field => `claims.${field}`).join(', ') };
+}
+
+// A YYYY-MM-DD string naming a real day. The round trip through Date rejects impossible
+// days such as 2025-02-30.
+function isCalendarDate(text) {
+    const day = /^\d{4}-\d{2}-\d{2}$/.test(text) ? new Date(`${text}T00:00:00Z`) : null;
+    return Boolean(day) && !isNaN(day.getTime()) && day.toISOString().slice(0, 10) === text;
+}
+
+function decodeCursor(cursor) {
+    const decoded = Buffer.from(String(cursor), 'base64url').toString('utf8');
+    const separator = decoded.indexOf('|');
+    if (separator === -1) return null;
+    const createdAt = new Date(Number(decoded.slice(0, separator)));
+    const claimId = decoded.slice(separator + 1);
+    if (isNaN(createdAt.getTime()) || !claimId) return null;
+    return { createdAt, claimId };
+}
+
+// A claim only changes through PATCH, which bumps updated_at, and its documents only gain
+// previews, so the version is the pair of those timestamps. Sets the ETag and reports
+// whether the client's copy is current; returns null when the claim doesn't exist. `db` is
+// the pool the response body will be read from, so ETag and body always agree.
+async function checkClaimVersion(req, res, claimId, db = pool) {
+    const query = `
+        SELECT c.created_at, c.updated_at, (
+            SELECT max(p.updated_at) FROM document_previews p
+            JOIN documents d ON d.id = p.document_id
+            WHERE d.claim_id = c.claim_id
+        ) AS previews_updated_at
+        FROM claims c WHERE c.claim_id = $1
+    `;
+    const result = await db.query(prepared(query, [claimId]));
+    if (result.rows.length === 0) return null;
+    const { created_at, updated_at, previews_updated_at } = result.rows[0];
+    const previewsVersion = previews_updated_at ? new Date(previews_updated_at).getTime() : 0;
+    res.set({
+        ETag: `W/"${claimId}-${new Date(updated_at || created_at).getTime()}-${previewsVersion}"`,
+        'Cache-Control': 'private, no-cache'
+    });
+    return { notModified: req.fresh };
+}
+
+async function fetchClaimDocuments(claimId, db = pool) {
+    const query = `
+        SELECT d.id, d.claim_id, d.file_name, d.file_path, d.uploaded_at, p.status AS preview_status
+        FROM documents d LEFT JOIN document_previews p ON p.document_id = d.id
+        WHERE d.claim_id = $1
+    `;
+    const result = await db.query(prepared(query, [claimId]));
+
+    // Verify files exist before returning them
+    return Promise.all(result.rows.map(async doc => {
+        const backend = storage.forPath(doc.file_path);
+        const exists = await backend.exists(doc.file_path);
+        return {
+            ...doc,
+            file_exists: exists,
+            url: exists ? backend.publicUrl(doc) : null,
+            preview_url: doc.preview_status === 'ready' ? `/api/documents/${doc.id}/preview` : null
+        };
+    }));
+}
+
+// A claim in the archive tier, with the ETag handling of checkClaimVersion; null when the
+// claim isn't archived. Archived claims never change again. Their documents are served
+// through GET /api/documents/:documentId only, since cold storage isn't under /uploads.
+async function fetchArchivedClaim(req, res, claimId) {
+    const [claimResult, documentResult] = await Promise.all([
+        pool.query(prepared(`SELECT ${CLAIM_ROW}, claims.archived_at FROM claims_archive claims WHERE claims.claim_id = $1`, [claimId])),
+        pool.query(prepared(
+            'SELECT id, claim_id, file_name, file_path, uploaded_at FROM documents_archive WHERE claim_id = $1 ORDER BY id',
+            [claimId]
+        ))
+    ]);
+    if (claimResult.rows.length === 0) return null;
+    const claim = claimResult.rows[0];
+    res.set({
+        ETag: `W/"${claimId}-archived-${new Date(claim.archived_at).getTime()}"`,
+        'Cache-Control': 'private, no-cache'
+    });
+    if (req.fresh) return { notModified: true };
+
+    const documents = await Promise.all(documentResult.rows.map(async doc => {
+        const exists = await storage.forPath(doc.file_path).exists(doc.file_path);
+        return {
+            ...doc,
+            preview_status: null,
+            file_exists: exists,
+            url: exists ? `/api/documents/${doc.id}` : null,
+            preview_url: null
+        };
+    }));
+    return { notModified: false, claim: { ...claim, archived: true }, documents };
+}
+
 // Initialize database
 async function initializeDatabase() {
     try {
-        console.log('Initializing database...');
-       
-        await pool.query(`
-            CREATE TABLE if not exists claims (
-                claim_id VARCHAR(20) PRIMARY KEY,
-                employee_name VARCHAR(100),
-                employee_email VARCHAR(100),
-                employee_id VARCHAR(10),
-                department VARCHAR(50),
-                claim_date DATE,
-                amount DECIMAL(10,2),
-                description TEXT,
-                type VARCHAR(50),
-                status VARCHAR(20),
-                created_at TIMESTAMP,
-                updated_at TIMESTAMP
-            )
-        `);
-        await pool.query(`
-            CREATE TABLE if not exists documents (
-                id SERIAL PRIMARY KEY,
-                claim_id VARCHAR(20) REFERENCES claims(claim_id) ON DELETE CASCADE,
-                file_name VARCHAR(255),
-                file_path VARCHAR(255),
-                uploaded_at TIMESTAMP
-            )
-        `);
-        console.log('Database initialized: tables created');
+        logger.info('Initializing database');
+        await runMigrations(pool);
+        logger.info('Database initialized: migrations applied');
     } catch (error) {
-        console.error('Error initializing database:', error.message, error.stack);
+        logger.error('Error initializing database', { error });
         process.exit(1);
     }
 }
 
+// Validates the `uploads` field of a claim submission: objects the browser already PUT to
+// the primary storage through POST /api/uploads. Returns document rows or an error message.
+async function resolveDirectUploads(raw) {
+    let uploads;
+    try {
+        uploads = JSON.parse(raw);
+    } catch (error) {
+        return { error: 'Uploads must be a JSON array' };
+    }
+    if (!Array.isArray(uploads)) {
+        return { error: 'Uploads must be a JSON array' };
+    }
+    if (!storage.primary.head) {
+        return { error: 'Direct uploads are not enabled on this server' };
+    }
+    for (const item of uploads) {
+        if (!item || typeof item.key !== 'string' || !/^documents\/[\w-]+\.(pdf|jpe?g|png)$/.test(item.key)
+            || typeof item.fileName !== 'string' || !item.fileName) {
+            return { error: 'Each upload needs a valid key and fileName' };
+        }
+    }
+
+    const objects = await Promise.all(uploads.map(item => storage.primary.head(item.key)));
+    const missing = uploads.filter((item, i) => !objects[i]);
+    if (missing.length > 0) {
+        return { error: `Uploaded documents not found: ${missing.map(item => item.fileName).join(', ')}` };
+    }
+
+    return {
+        documents: uploads.map((item, i) => {
+            const hash = /^documents\/([0-9a-f]{64})\./.exec(item.key);
+            return {
+                fileName: item.fileName,
+                filePath: storage.primary.locationFor(item.key),
+                contentHash: hash ? hash[1] : null,
+                size: objects[i].size
+            };
+        })
+    };
+}
+
+// Removes multipart files of a submission that did not create a claim, keeping content
+// other documents share
+async function discardUploadedFiles(req) {
+    await storage.local.releaseCopies(req.files || []);
+    for (const file of req.files || []) {
+        if (file.deduplicated) continue;
+        try {
+            if (await storage.local.removeUnreferenced(file)) {
+                req.log.info('Deleted unused upload', { path: file.path });
+            }
+        } catch (err) {
+            req.log.error('Error deleting file', { path: file.path, error: err });
+        }
+    }
+}
+
+// Answers a retried submission with the claim its Idempotency-Key already created
+async function replayClaim(req, res, claimId) {
+    await discardUploadedFiles(req);
+    const result = await pool.query(prepared(
+        'SELECT file_name, file_path, content_hash FROM documents WHERE claim_id = $1 ORDER BY id',
+        [claimId]
+    ));
+    req.log.info('Claim submission replayed', { claimId });
+    res.set('Idempotent-Replayed', 'true');
+    res.status(201).json({
+        message: 'Claim submitted successfully',
+        claimId,
+        documents: result.rows.map(doc => ({
+            originalName: doc.file_name,
+            storedPath: doc.file_path,
+            contentHash: doc.content_hash && doc.content_hash.trim()
+        }))
+    });
+}
+
+function sendUploadError(req, res, error, context) {
+    if (!(error instanceof UploadError)) {
+        req.log.error(`Error processing ${context}`, { error });
+        return res.status(500).json({ error: 'Server error while uploading' });
+    }
+    if (error.offset !== undefined) {
+        res.set('Upload-Offset', String(error.offset));
+    }
+    res.status(error.status).json({ error: error.message });
+}
+
+// POST /api/uploads
+// Issues presigned PUT targets when documents live in object storage. With local
+// storage it answers { direct: false } and the browser sends files with the claim.
+app.post('/api/uploads', async (req, res) => {
+    req.log.debug('POST /api/uploads payload', { body: req.body });
+
+    try {
+        const files = req.body && req.body.files;
+        if (!Array.isArray(files) || files.length === 0 || files.length > MAX_DOCUMENTS_PER_CLAIM) {
+            return res.status(400).json({ error: `Between 1 and ${MAX_DOCUMENTS_PER_CLAIM} files are required` });
+        }
+        for (const file of files) {
+            if (!file || typeof file.fileName !== 'string' || !ALLOWED_DOCUMENT_TYPES.includes(file.contentType)) {
+                return res.status(400).json({ error: 'Only PDF, JPG, and PNG files are allowed' });
+            }
+            if (!Number.isInteger(file.size) || file.size <= 0 || file.size > MAX_DOCUMENT_SIZE) {
+                return res.status(400).json({ error: 'File size exceeds 5MB limit' });
+            }
+        }
+
+        const uploads = await storage.primary.presignUploads(files);
+        if (!uploads) {
+            return res.json({ direct: false });
+        }
+        res.json({ direct: true, uploads });
+    } catch (error) {
+        req.log.error('Error processing POST /api/uploads', { error });
+        res.status(500).json({ error: 'Server error while preparing uploads' });
+    }
+});
+
+// POST /api/uploads/sessions
+// Starts a resumable upload of one document: { fileName, contentType, size, sha256? }.
+// Already-stored content (matching sha256) comes back complete with nothing to send.
+app.post('/api/uploads/sessions', async (req, res) => {
+    try {
+        const session = await uploadSessions.create(req.body || {});
+        req.log.debug('Upload session created', session);
+        res.set({ 'Location': `/api/uploads/sessions/${session.id}`, 'Upload-Offset': String(session.offset) });
+        res.status(201).json(session);
+    } catch (error) {
+        sendUploadError(req, res, error, 'POST /api/uploads/sessions');
+    }
+});
+
+// HEAD /api/uploads/sessions/:sessionId
+// How many bytes the server holds, so an interrupted upload resumes from there
+app.head('/api/uploads/sessions/:sessionId', async (req, res) => {
+    try {
+        const status = await uploadSessions.status(req.params.sessionId);
+        res.set({
+            'Upload-Offset': String(status.offset),
+            'Upload-Length': String(status.size),
+            'Cache-Control': 'no-store'
+        });
+        res.status(204).end();
+    } catch (error) {
+        sendUploadError(req, res, error, 'HEAD /api/uploads/sessions/:sessionId');
+    }
+});
+
+// PATCH /api/uploads/sessions/:sessionId
+// Appends an application/offset+octet-stream body at Upload-Offset. A mismatched offset is
+// answered with 409 and the server's offset.
+app.patch('/api/uploads/sessions/:sessionId', async (req, res) => {
+    const offset = Number(req.get('Upload-Offset'));
+    if (!req.is('application/offset+octet-stream') || !Number.isInteger(offset) || offset < 0) {
+        return res.status(415).json({ error: 'Send application/offset+octet-stream with an Upload-Offset header' });
+    }
+    try {
+        const status = await uploadSessions.append(req.params.sessionId, offset, req);
+        res.set({ 'Upload-Offset': String(status.offset), 'Cache-Control': 'no-store' });
+        res.status(204).end();
+    } catch (error) {
+        sendUploadError(req, res, error, 'PATCH /api/uploads/sessions/:sessionId');
+    }
+});
+
 // POST /api/claims
-app.post('/api/claims', upload.array('documents', 5), async (req, res) => {
-    console.log('Received POST /api/claims at', new Date().toISOString());
-    console.log('Request headers:', req.headers);
-    console.log('Request body:', req.body);
-    console.log('Files received:', req.files ? req.files.map(f => ({
-        originalname: f.originalname,
-        mimetype: f.mimetype,
-        size: f.size,
-        path: f.path
-    })) : 'None');
+app.post('/api/claims', upload.array('documents', MAX_DOCUMENTS_PER_CLAIM), async (req, res) => {
+    req.log.debug('POST /api/claims payload', {
+        headers: req.headers,
+        body: req.body,
+        files: req.files ? req.files.map(f => ({
+            originalname: f.originalname,
+            mimetype: f.mimetype,
+            size: f.size,
+            path: f.path
+        })) : []
+    });
 
+    const idempotencyKey = req.get('Idempotency-Key') || null;
+    // Every rejection removes the files multer has already stored for this request
+    const reject = async (message, reason, details = {}) => {
+        req.log.info('Validation failed', { reason, ...details });
+        await discardUploadedFiles(req);
+        return res.status(400).json({ error: message });
+    };
     try {
+        if (idempotencyKey) {
+            if (!IDEMPOTENCY_KEY_PATTERN.test(idempotencyKey)) {
+                return await reject('Idempotency-Key must be 8-64 letters, digits, _ or -', 'Invalid Idempotency-Key');
+            }
+            const existing = await pool.query(prepared(CLAIM_BY_IDEMPOTENCY_KEY, [idempotencyKey]));
+            if (existing.rows.length > 0) {
+                return await replayClaim(req, res, existing.rows[0].claim_id);
+            }
+        }
+
         const { empName, empEmail, empId, department, claimDate, amount, description, type } = req.body;
-        console.log('Parsed fields:', { empName, empEmail, empId, department, claimDate, amount, description, type });
 
         if (!empName || !empEmail || !empId || !department || !claimDate || !amount || !description || !type) {
-            console.log('Validation failed: Missing required fields');
-            return res.status(400).json({ error: 'All fields are required' });
+            return await reject('All fields are required', 'Missing required fields');
         }
 
         if (!/^ATS0[1-9]\d{2}$/.test(empId)) {
-            console.log('Validation failed: Invalid empId format');
-            return res.status(400).json({ error: 'Employee ID must be ATS0 followed by 3 digits (e.g., ATS0123)' });
+            return await reject('Employee ID must be ATS0 followed by 3 digits (e.g., ATS0123)', 'Invalid empId format');
         }
 
         if (!/^[a-zA-Z0-9](?:[a-zA-Z0-9]|(?![._-]{2})[._-]){2,}@astrolitetech\.com$/.test(empEmail)) {
-            console.log('Validation failed: Invalid email');
-            return res.status(400).json({ error: 'Email must be a valid @astrolitetech.com address, min 3 chars before @, no consecutive _-.' });
+            return await reject('Email must be a valid @astrolitetech.com address, min 3 chars before @, no consecutive _-.', 'Invalid email');
         }
 
         const amountValue = parseFloat(amount);
         if (isNaN(amountValue) || amountValue <= 0 || amountValue > 50000) {
-            console.log('Validation failed: Invalid amount');
-            return res.status(400).json({ error: 'Amount must be between ₹0.01 and ₹50,000' });
+            return await reject('Amount must be between ₹0.01 and ₹50,000', 'Invalid amount');
         }
 
         const claimDateObj = new Date(claimDate);
@@ -151,25 +568,74 @@ app.post('/api/claims', upload.array('documents', 5), async (req, res) => {
         const threeMonthsAgo = new Date();
         threeMonthsAgo.setMonth(today.getMonth() - 3);
         if (claimDateObj > today || claimDateObj < threeMonthsAgo) {
-            console.log('Validation failed: Invalid claim date');
-            return res.status(400).json({ error: 'Claim date must be within the last 3 months and not in the future' });
+            return await reject('Claim date must be within the last 3 months and not in the future', 'Invalid claim date');
+        }
+
+        let directDocuments = [];
+        let sessionIds = [];
+        if (req.body.uploads) {
+            const resolved = await resolveDirectUploads(req.body.uploads);
+            if (resolved.error) {
+                return await reject(resolved.error, resolved.error);
+            }
+            directDocuments = resolved.documents;
+        }
+        if (req.body.uploadSessions) {
+            const resolved = await uploadSessions.resolve(req.body.uploadSessions);
+            if (resolved.error) {
+                return await reject(resolved.error, resolved.error);
+            }
+            directDocuments.push(...resolved.documents);
+            sessionIds = resolved.sessionIds;
+        }
+
+        const documentCount = (req.files ? req.files.length : 0) + directDocuments.length;
+        if (documentCount === 0) {
+            return await reject('At least one document is required', 'No documents uploaded');
         }
+        if (documentCount > MAX_DOCUMENTS_PER_CLAIM) {
+            return await reject(`At most ${MAX_DOCUMENTS_PER_CLAIM} documents are allowed`, 'Too many documents');
+        }
+
+        const documents = [];
+        const uploadedFiles = req.files || [];
+        // Ensure the files exist before saving to database; checked in parallel off the event loop
+        const stored = await Promise.all(uploadedFiles.map(file => storage.local.exists(file.path)));
+        uploadedFiles.forEach((file, i) => {
+            if (!stored[i]) {
+                req.log.error('File not saved to disk', { path: file.path });
+                return;
+            }
+            documents.push({
+                fileName: file.originalname,
+                filePath: file.path,
+                tempPath: file.tempPath,
+                contentHash: file.contentHash,
+                size: file.size
+            });
+        });
+        documents.push(...directDocuments);
 
-        if (!req.files || req.files.length === 0) {
-            console.log('Validation failed: No documents uploaded');
-            return res.status(400).json({ error: 'At least one document is required' });
+        // Own keys only: a type such as "constructor" must not pick up an Object.prototype member
+        const uploadLimit = Object.hasOwn(CLAIM_TYPE_UPLOAD_LIMITS, type) ? CLAIM_TYPE_UPLOAD_LIMITS[type] : CLAIM_TYPE_UPLOAD_LIMITS.Other;
+        const uploadBytes = documents.reduce((sum, doc) => sum + (Number(doc.size) || 0), 0);
+        if (uploadBytes > uploadLimit) {
+            return await reject(
+                `${type} claims allow at most ${uploadLimit / (1024 * 1024)}MB of documents in total`,
+                'Claim documents too large',
+                { type, uploadBytes, uploadLimit }
+            );
         }
 
-        const claimId = `CLM-${new Date().getFullYear()}-${Math.floor(1000 + Math.random() * 9000)}`;
-        console.log('Generated claimId:', claimId);
+        const now = new Date();
 
+        // next_claim_id() draws from claim_id_seq, so IDs never collide and arrive in order
         const query = `
-            INSERT INTO claims (claim_id, employee_name, employee_email, employee_id, department, claim_date, amount, description, type, status, created_at, updated_at)
-            VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12)
+            INSERT INTO claims (claim_id, employee_name, employee_email, employee_id, department, claim_date, amount, description, type, status, created_at, updated_at, idempotency_key)
+            VALUES (next_claim_id($10), $1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12)
             RETURNING claim_id
         `;
         const values = [
-            claimId,
             empName,
             empEmail,
             empId,
@@ -179,82 +645,120 @@ app.post('/api/claims', upload.array('documents', 5), async (req, res) => {
             description,
             type,
             'pending',
-            new Date(),
-            new Date()
+            now,
+            now,
+            idempotencyKey
+        ];
+
+        // All documents go in one multi-row INSERT, one array parameter per column, and each
+        // gets a pending preview row in the same statement
+        const docQuery = `
+            WITH inserted AS (
+                INSERT INTO documents (claim_id, uploaded_at, file_name, file_path, content_hash, size_bytes)
+                SELECT $1, $2, d.file_name, d.file_path, d.content_hash, d.size_bytes
+                FROM unnest($3::varchar[], $4::varchar[], $5::char(64)[], $6::bigint[])
+                    AS d(file_name, file_path, content_hash, size_bytes)
+                RETURNING id
+            )
+            INSERT INTO document_previews (document_id)
+            SELECT id FROM inserted
+            RETURNING document_id
+        `;
+        const docValues = [
+            null,  // claim_id, known once the claim row is inserted
+            now,
+            documents.map(doc => doc.fileName),
+            documents.map(doc => doc.filePath),  // Full local path or s3://bucket/key
+            documents.map(doc => doc.contentHash),
+            documents.map(doc => doc.size)
         ];
-        console.log('Executing SQL INSERT with values:', values);
 
-        const result = await pool.query(query, values);
-        console.log('Database insert result:', result.rows);
+        // The claim, its documents and their follow-up jobs commit together on one
+        // connection, or not at all
+        const claimId = await withTransaction(async client => {
+            if (!(await uploadSessions.consume(client, sessionIds))) return null;
+            // Stored files of this upload can't be removed from here until the documents commit
+            await storage.local.retain(client, documents);
+            req.log.debug('Executing SQL INSERT', { values });
+            const result = await client.query(prepared(query, values));
+            docValues[0] = result.rows[0].claim_id;
+            if (documents.length > 0) {
+                req.log.debug('Inserting documents', { values: docValues });
+                const docResult = await client.query(prepared(docQuery, docValues));
+                await previews.enqueue(client, docResult.rows.map(row => row.document_id));
+            }
+            return result.rows[0].claim_id;
+        });
 
-        // Process each uploaded file
-        for (const file of req.files) {
-            // Ensure the file exists before saving to database
-            if (!fs.existsSync(file.path)) {
-                console.error('File not saved to disk:', file.path);
-                continue;
+        if (claimId === null) {
+            // A concurrent retry with the same key may have used the sessions for this claim
+            if (idempotencyKey) {
+                const existing = await pool.query(prepared(CLAIM_BY_IDEMPOTENCY_KEY, [idempotencyKey]));
+                if (existing.rows.length > 0) {
+                    return await replayClaim(req, res, existing.rows[0].claim_id);
+                }
             }
+            return await reject('Uploads already used by another claim or expired', 'Upload sessions not available');
+        }
 
-            const docQuery = `
-                INSERT INTO documents (claim_id, file_name, file_path, uploaded_at)
-                VALUES ($1, $2, $3, $4)
-                RETURNING id
-            `;
-            const docValues = [
-                claimId,
-                file.originalname,
-                file.path,  // This stores the full path to the file
-                new Date()
-            ];
-            console.log('Inserting document:', docValues);
-            const docResult = await pool.query(docQuery, docValues);
-            console.log('Document insert result:', docResult.rows);
-        }
-
-        console.log('Claim and documents saved successfully');
+        req.log.info('Claim submitted', { claimId, documents: documents.length });
+        await storage.local.releaseCopies(uploadedFiles);
+        jobs.wake();
         res.status(201).json({ 
             message: 'Claim submitted successfully', 
             claimId,
-            documents: req.files.map(f => ({
-                originalName: f.originalname,
-                storedPath: f.path
+            documents: documents.map(doc => ({
+                originalName: doc.fileName,
+                storedPath: doc.filePath,
+                contentHash: doc.contentHash
             }))
         });
     } catch (error) {
-        console.error('Error processing POST /api/claims:', error.message, error.stack);
-        
-        // Clean up uploaded files if there was an error
-        if (req.files && req.files.length > 0) {
-            req.files.forEach(file => {
-                try {
-                    if (fs.existsSync(file.path)) {
-                        fs.unlinkSync(file.path);
-                        console.log('Deleted file due to error:', file.path);
-                    }
-                } catch (err) {
-                    console.error('Error deleting file:', err.message);
-                }
-            });
+        // Two concurrent retries with the same key: the unique index lets only one insert
+        if (error.code === '23505' && error.constraint === 'claim_idempotency_keys_pkey') {
+            try {
+                const existing = await pool.query(prepared(CLAIM_BY_IDEMPOTENCY_KEY, [idempotencyKey]));
+                return await replayClaim(req, res, existing.rows[0].claim_id);
+            } catch (replayError) {
+                error = replayError;
+            }
         }
-        
+        req.log.error('Error processing POST /api/claims', { error });
+
+        // Clean up uploaded files if there was an error
+        await discardUploadedFiles(req);
+
         res.status(500).json({ error: 'Server error while submitting claim' });
     }
 });
 
 // GET /api/claims
 app.get('/api/claims', async (req, res) => {
-    console.log('Received GET /api/claims at', new Date().toISOString());
-    console.log('Request headers:', req.headers);
-    console.log('Query params:', req.query);
+    req.log.debug('GET /api/claims', { query: req.query });
 
     try {
-        const { employee_id, claim_id, status } = req.query;
-        let query = 'SELECT * FROM claims WHERE 1=1';
+        const { employee_id, claim_id, status, cursor, limit, include, fields } = req.query;
+        const includes = include ? include.split(',').map(s => s.trim()) : [];
+
+        const { projection, error: projectionError } = claimProjection(fields);
+        if (projectionError) {
+            req.log.info('Validation failed', { reason: 'Invalid fields' });
+            return res.status(400).json({ error: projectionError });
+        }
+
+        // Documents are opt-in and aggregated in the same statement instead of one query per claim
+        const columns = includes.includes('documents')
+            ? `${projection}, COALESCE((
+                SELECT json_agg(json_build_object('id', d.id, 'file_name', d.file_name, 'file_path', d.file_path) ORDER BY d.id)
+                FROM documents d WHERE d.claim_id = claims.claim_id
+            ), '[]'::json) AS documents`
+            : projection;
+        let query = `SELECT ${columns} FROM claims WHERE 1=1`;
         const values = [];
 
         if (employee_id) {
             if (!/^ATS0[1-9]\d{2}$/.test(employee_id)) {
-                console.log('Validation failed: Invalid employee_id format');
+                req.log.info('Validation failed', { reason: 'Invalid employee_id format' });
                 return res.status(400).json({ error: 'Employee ID must be ATS0 followed by 3 digits' });
             }
             values.push(employee_id);
@@ -265,118 +769,572 @@ app.get('/api/claims', async (req, res) => {
             query += ` AND claim_id = $${values.length}`;
         }
         if (status) {
-            values.push(status);
-            query += ` AND status = $${values.length}`;
+            // Accepts a single status or a group such as "approved,rejected"
+            const statuses = status.split(',').map(s => s.trim()).filter(Boolean);
+            if (statuses.some(s => !CLAIM_STATUSES.includes(s))) {
+                req.log.info('Validation failed', { reason: 'Invalid status filter' });
+                return res.status(400).json({ error: `Status must be one of ${CLAIM_STATUSES.join(', ')}` });
+            }
+            values.push(statuses);
+            query += ` AND status = ANY($${values.length})`;
         }
 
-        query += ' ORDER BY created_at DESC';
-        console.log('Executing SQL SELECT:', query, 'with values:', values);
-        const result = await pool.query(query, values);
-        
-        // For each claim, get its documents
-        const claimsWithDocuments = await Promise.all(result.rows.map(async claim => {
-            const docsQuery = 'SELECT id, file_name, file_path FROM documents WHERE claim_id = $1';
-            const docsResult = await pool.query(docsQuery, [claim.claim_id]);
-            return {
-                ...claim,
-                documents: docsResult.rows
-            };
-        }));
-        
-        console.log('Returning claims with documents');
-        res.json(claimsWithDocuments);
+        let pageSize = null;
+        if (limit !== undefined) {
+            pageSize = parseInt(limit, 10);
+            if (isNaN(pageSize) || pageSize < 1 || pageSize > MAX_PAGE_SIZE) {
+                req.log.info('Validation failed', { reason: 'Invalid limit' });
+                return res.status(400).json({ error: `Limit must be between 1 and ${MAX_PAGE_SIZE}` });
+            }
+        }
+        if (cursor) {
+            const position = decodeCursor(cursor);
+            if (!position) {
+                req.log.info('Validation failed', { reason: 'Invalid cursor' });
+                return res.status(400).json({ error: 'Invalid cursor' });
+            }
+            values.push(position.createdAt, position.claimId);
+            query += ` AND (created_at, claim_id) < ($${values.length - 1}, $${values.length})`;
+        }
+
+        query += ' ORDER BY created_at DESC, claim_id DESC';
+        if (pageSize) {
+            // Fetch one extra row to learn whether another page follows
+            values.push(pageSize + 1);
+            query += ` LIMIT $${values.length}`;
+        }
+        req.log.debug('Executing SQL SELECT', { query, values });
+        // Listings tolerate replica lag; the dashboards catch up through /changes on the primary
+        const result = await readPool.query(prepared(query, values));
+
+        if (pageSize && result.rows.length > pageSize) {
+            result.rows.length = pageSize;
+            res.set('X-Next-Cursor', encodeCursor(result.rows[pageSize - 1]));
+        }
+
+        res.json(result.rows);
     } catch (error) {
-        console.error('Error processing GET /api/claims:', error.message, error.stack);
+        req.log.error('Error processing GET /api/claims', { error });
         res.status(500).json({ error: 'Server error while fetching claims' });
     }
 });
 
+// GET /api/claims/changes
+// Claims inserted or modified at or after `since`, oldest change first, keyset-paginated
+// with X-Next-Cursor. X-High-Water-Mark is the `since` for the next sync. Delivery is
+// at-least-once (the mark trails recent writes), so clients upsert by claim_id.
+app.get('/api/claims/changes', async (req, res) => {
+    try {
+        const { since, cursor, limit, employee_id } = req.query;
+
+        let position;
+        if (cursor) {
+            const decoded = decodeCursor(cursor);
+            if (!decoded) {
+                req.log.info('Validation failed', { reason: 'Invalid cursor' });
+                return res.status(400).json({ error: 'Invalid cursor' });
+            }
+            position = { updatedAt: decoded.createdAt, claimId: decoded.claimId };
+        } else {
+            const sinceDate = since === undefined ? new Date(0) : new Date(/^\d+$/.test(since) ? Number(since) : since);
+            if (isNaN(sinceDate.getTime())) {
+                req.log.info('Validation failed', { reason: 'Invalid since' });
+                return res.status(400).json({ error: 'Since must be an ISO timestamp or epoch milliseconds' });
+            }
+            // '' sorts before every claim_id, so rows stamped exactly at `since` are included
+            position = { updatedAt: sinceDate, claimId: '' };
+        }
+
+        const pageSize = limit === undefined ? MAX_PAGE_SIZE : parseInt(limit, 10);
+        if (isNaN(pageSize) || pageSize < 1 || pageSize > MAX_PAGE_SIZE) {
+            req.log.info('Validation failed', { reason: 'Invalid limit' });
+            return res.status(400).json({ error: `Limit must be between 1 and ${MAX_PAGE_SIZE}` });
+        }
+
+        const values = [position.updatedAt, position.claimId];
+        let query = `SELECT ${CLAIM_ROW} FROM claims WHERE (updated_at, claim_id) > ($1, $2)`;
+        if (employee_id) {
+            if (!/^ATS0[1-9]\d{2}$/.test(employee_id)) {
+                req.log.info('Validation failed', { reason: 'Invalid employee_id format' });
+                return res.status(400).json({ error: 'Employee ID must be ATS0 followed by 3 digits' });
+            }
+            values.push(employee_id);
+            query += ` AND employee_id = $${values.length}`;
+        }
+        values.push(pageSize + 1);
+        query += ` ORDER BY updated_at, claim_id LIMIT $${values.length}`;
+
+        // Read the clock before the query so the mark never passes rows the query could not see
+        const settled = settledHighWaterMark();
+        const result = await pool.query(prepared(query, values));
+
+        let highWaterMark;
+        if (result.rows.length > pageSize) {
+            result.rows.length = pageSize;
+            res.set('X-Next-Cursor', encodeCursor(result.rows[pageSize - 1], 'updated_at'));
+            // More rows follow; the mark may not pass the last one returned
+            const newest = new Date(result.rows[pageSize - 1].updated_at);
+            highWaterMark = newest < settled ? newest : settled;
+        } else {
+            // Every visible change was returned; only writes that are still settling can appear later
+            highWaterMark = settled > position.updatedAt ? settled : position.updatedAt;
+        }
+        res.set('X-High-Water-Mark', highWaterMark.toISOString());
+
+        res.json(result.rows);
+    } catch (error) {
+        req.log.error('Error processing GET /api/claims/changes', { error });
+        res.status(500).json({ error: 'Server error while fetching claim changes' });
+    }
+});
+
+// GET /api/claims/summary
+// Counts and totals per status and type over all claims, archived ones included.
+// X-High-Water-Mark lets a client that loaded the summary and tables now catch up later
+// through GET /api/claims/changes.
+app.get('/api/claims/summary', async (req, res) => {
+    try {
+        res.set('X-High-Water-Mark', settledHighWaterMark().toISOString());
+        const query = `
+            SELECT status, type, SUM(claim_count)::int AS count, SUM(total_amount)::float8 AS total
+            FROM claim_totals
+            GROUP BY status, type
+            HAVING SUM(claim_count) > 0
+            ORDER BY status, type
+        `;
+        const result = await pool.query(prepared(query, []));
+        res.json(result.rows);
+    } catch (error) {
+        req.log.error('Error processing GET /api/claims/summary', { error });
+        res.status(500).json({ error: 'Server error while fetching claim summary' });
+    }
+});
+
+// GET /api/claims/search
+// Full-text search over employee name, description, department and type (?q=, every word
+// matched as a prefix), narrowed by status, type, department, amount_min/amount_max and
+// date_from/date_to (claim date). Returns one page of claims, best match first, with the
+// total match count and per-facet counts over all matches: status, type, department,
+// amount range and claim month. Paged with limit and offset.
+app.get('/api/claims/search', async (req, res) => {
+    req.log.debug('GET /api/claims/search', { query: req.query });
+
+    try {
+        const { q, status, type, department, amount_min, amount_max, date_from, date_to, limit, offset, fields } = req.query;
+
+        const { projection, error: projectionError } = claimProjection(fields);
+        if (projectionError) {
+            req.log.info('Validation failed', { reason: 'Invalid fields' });
+            return res.status(400).json({ error: projectionError });
+        }
+
+        const conditions = [];
+        const values = [];
+        let rank = null;
+
+        const terms = q ? String(q).toLowerCase().match(/[\p{L}\p{N}]+/gu) || [] : [];
+        if (terms.length > MAX_SEARCH_TERMS) {
+            req.log.info('Validation failed', { reason: 'Too many search terms' });
+            return res.status(400).json({ error: `Search at most ${MAX_SEARCH_TERMS} words at a time` });
+        }
+        if (terms.length > 0) {
+            // Terms are letters and digits only, so they need no tsquery escaping
+            values.push(terms.map(term => `${term}:*`).join(' & '));
+            conditions.push(`search_vector @@ to_tsquery('simple', $${values.length})`);
+            rank = `ts_rank(search_vector, to_tsquery('simple', $${values.length}))`;
+        }
+
+        if (status) {
+            const statuses = status.split(',').map(s => s.trim()).filter(Boolean);
+            if (statuses.some(s => !CLAIM_STATUSES.includes(s))) {
+                req.log.info('Validation failed', { reason: 'Invalid status filter' });
+                return res.status(400).json({ error: `Status must be one of ${CLAIM_STATUSES.join(', ')}` });
+            }
+            values.push(statuses);
+            conditions.push(`status = ANY($${values.length})`);
+        }
+        for (const [column, filter] of [['type', type], ['department', department]]) {
+            if (!filter) continue;
+            values.push(filter.split(',').map(s => s.trim()).filter(Boolean));
+            conditions.push(`${column} = ANY($${values.length})`);
+        }
+
+        for (const [operator, bound, name] of [['>=', amount_min, 'amount_min'], ['<=', amount_max, 'amount_max']]) {
+            if (bound === undefined || bound === '') continue;
+            const amountValue = parseFloat(bound);
+            if (isNaN(amountValue)) {
+                req.log.info('Validation failed', { reason: `Invalid ${name}` });
+                return res.status(400).json({ error: `${name} must be a number` });
+            }
+            values.push(amountValue);
+            conditions.push(`amount ${operator} $${values.length}`);
+        }
+
+        for (const [operator, bound, name] of [['>=', date_from, 'date_from'], ['<=', date_to, 'date_to']]) {
+            if (!bound) continue;
+            if (!isCalendarDate(bound)) {
+                req.log.info('Validation failed', { reason: `Invalid ${name}` });
+                return res.status(400).json({ error: `${name} must be a date (YYYY-MM-DD)` });
+            }
+            values.push(bound);
+            conditions.push(`claim_date ${operator} $${values.length}`);
+        }
+
+        const pageSize = limit === undefined ? SEARCH_PAGE_SIZE : parseInt(limit, 10);
+        if (isNaN(pageSize) || pageSize < 1 || pageSize > MAX_PAGE_SIZE) {
+            req.log.info('Validation failed', { reason: 'Invalid limit' });
+            return res.status(400).json({ error: `Limit must be between 1 and ${MAX_PAGE_SIZE}` });
+        }
+        const skip = offset === undefined ? 0 : parseInt(offset, 10);
+        if (isNaN(skip) || skip < 0 || skip > MAX_SEARCH_OFFSET) {
+            req.log.info('Validation failed', { reason: 'Invalid offset' });
+            return res.status(400).json({ error: `Offset must be between 0 and ${MAX_SEARCH_OFFSET}; narrow the search instead` });
+        }
+
+        const where = conditions.length > 0 ? `WHERE ${conditions.join(' AND ')}` : '';
+        const pageQuery = `
+            SELECT ${projection} FROM claims ${where}
+            ORDER BY ${rank ? `${rank} DESC, ` : ''}created_at DESC, claim_id DESC
+            LIMIT $${values.length + 1} OFFSET $${values.length + 2}
+        `;
+        // Every facet, and the total, from one pass over the matching rows
+        const facetQuery = `
+            SELECT CASE
+                       WHEN GROUPING(status) = 0 THEN 'status'
+                       WHEN GROUPING(type) = 0 THEN 'type'
+                       WHEN GROUPING(department) = 0 THEN 'department'
+                       WHEN GROUPING(amount_bucket) = 0 THEN 'amount'
+                       WHEN GROUPING(claim_month) = 0 THEN 'month'
+                       ELSE 'total'
+                   END AS facet,
+                   COALESCE(status, type, department, amount_bucket::text, claim_month) AS value,
+                   count(*)::int AS count,
+                   COALESCE(sum(amount), 0)::float8 AS total
+            FROM (
+                SELECT status, type, department, amount,
+                       width_bucket(amount, $${values.length + 1}::numeric[]) AS amount_bucket,
+                       to_char(claim_date, 'YYYY-MM') AS claim_month
+                FROM claims ${where}
+            ) matched
+            GROUP BY GROUPING SETS ((), (status), (type), (department), (amount_bucket), (claim_month))
+        `;
+        req.log.debug('Executing claim search', { pageQuery, values });
+        // Search tolerates replica lag like the listings do
+        const [page, facetRows] = await Promise.all([
+            readPool.query(prepared(pageQuery, [...values, pageSize, skip])),
+            readPool.query(prepared(facetQuery, [...values, AMOUNT_FACET_BOUNDS]))
+        ]);
+
+        let total = 0;
+        const facets = { status: [], type: [], department: [], amount: [], month: [] };
+        for (const row of facetRows.rows) {
+            if (row.facet === 'total') {
+                total = row.count;
+            } else if (row.facet === 'amount') {
+                // width_bucket numbers the range below the first bound 0
+                const bucket = row.value === null ? null : Number(row.value);
+                facets.amount.push({
+                    min: bucket === null ? null : bucket === 0 ? 0 : AMOUNT_FACET_BOUNDS[bucket - 1],
+                    max: bucket === null ? null : AMOUNT_FACET_BOUNDS[bucket] || null,
+                    count: row.count,
+                    total: row.total
+                });
+            } else {
+                facets[row.facet].push({ value: row.value, count: row.count, total: row.total });
+            }
+        }
+        facets.amount.sort((a, b) => (a.min === null ? -1 : a.min) - (b.min === null ? -1 : b.min));
+        facets.month.sort((a, b) => (b.value || '').localeCompare(a.value || ''));
+        for (const name of ['status', 'type', 'department']) {
+            facets[name].sort((a, b) => b.count - a.count);
+        }
+
+        const nextOffset = skip + page.rows.length < total ? skip + page.rows.length : null;
+        res.json({ total, nextOffset, claims: page.rows, facets });
+    } catch (error) {
+        req.log.error('Error processing GET /api/claims/search', { error });
+        res.status(500).json({ error: 'Server error while searching claims' });
+    }
+});
+
+// GET /api/claims/export
+// Every claim submitted from `from` through `to` (YYYY-MM-DD, both optional and inclusive),
+// optionally only with the given statuses, as a CSV or XLSX download (?format=csv|xlsx,
+// default csv), oldest first. Rows stream from a database cursor as the client reads them,
+// so memory use doesn't grow with the export. Archived claims are not included.
+app.get('/api/claims/export', async (req, res) => {
+    req.log.debug('GET /api/claims/export', { query: req.query });
+
+    try {
+        const { format = 'csv', from, to, status } = req.query;
+
+        if (!Object.prototype.hasOwnProperty.call(EXPORT_FORMATS, format)) {
+            req.log.info('Validation failed', { reason: 'Invalid export format' });
+            return res.status(400).json({ error: `Format must be one of ${Object.keys(EXPORT_FORMATS).join(', ')}` });
+        }
+
+        const conditions = [];
+        const values = [];
+        // Bounds on created_at, the partition key, so only the months asked for are read
+        for (const [operator, bound, name] of [['>=', from, 'from'], ['<', to, 'to']]) {
+            if (!bound) continue;
+            if (!isCalendarDate(bound)) {
+                req.log.info('Validation failed', { reason: `Invalid ${name}` });
+                return res.status(400).json({ error: `${name} must be a date (YYYY-MM-DD)` });
+            }
+            values.push(bound);
+            conditions.push(operator === '<'
+                ? `created_at < $${values.length}::date + 1`
+                : `created_at >= $${values.length}::date`);
+        }
+        if (from && to && from > to) {
+            req.log.info('Validation failed', { reason: 'Export range ends before it starts' });
+            return res.status(400).json({ error: 'from must not be after to' });
+        }
+
+        if (status) {
+            const statuses = status.split(',').map(s => s.trim()).filter(Boolean);
+            if (statuses.some(s => !CLAIM_STATUSES.includes(s))) {
+                req.log.info('Validation failed', { reason: 'Invalid status filter' });
+                return res.status(400).json({ error: `Status must be one of ${CLAIM_STATUSES.join(', ')}` });
+            }
+            values.push(statuses);
+            conditions.push(`status = ANY($${values.length})`);
+        }
+
+        const where = conditions.length > 0 ? `WHERE ${conditions.join(' AND ')}` : '';
+        const filename = `claims-${from || 'start'}-to-${to || new Date().toISOString().slice(0, 10)}`;
+        // A report tolerates replica lag like the listings do
+        await streamClaimExport({ db: readPool, where, values, format, filename, res, log: req.log });
+    } catch (error) {
+        req.log.error('Error processing GET /api/claims/export', { error });
+        if (res.headersSent) return;
+        res.status(500).json({ error: 'Server error while exporting claims' });
+    }
+});
+
+// GET /api/claims/events
+// Server-Sent Events stream of claim deltas (new claims and status changes)
+app.get('/api/claims/events', (req, res) => {
+    changeFeed.subscribe(req, res);
+});
+
+// GET /api/claims/by-key/:key
+// Whether a submission with this Idempotency-Key created a claim, for a browser whose
+// connection dropped before the response arrived
+app.get('/api/claims/by-key/:key', async (req, res) => {
+    try {
+        if (!IDEMPOTENCY_KEY_PATTERN.test(req.params.key)) {
+            req.log.info('Validation failed', { reason: 'Invalid Idempotency-Key' });
+            return res.status(400).json({ error: 'Invalid idempotency key' });
+        }
+        const result = await pool.query(prepared(
+            `SELECT c.claim_id, c.status, c.created_at
+             FROM claim_idempotency_keys k JOIN claims c ON c.claim_id = k.claim_id
+             WHERE k.idempotency_key = $1`,
+            [req.params.key]
+        ));
+        res.set('Cache-Control', 'no-store');
+        if (result.rows.length === 0) {
+            return res.status(404).json({ error: 'No claim submitted with this key' });
+        }
+        const claim = result.rows[0];
+        res.json({ claimId: claim.claim_id, status: claim.status, createdAt: claim.created_at });
+    } catch (error) {
+        req.log.error('Error processing GET /api/claims/by-key/:key', { error });
+        res.status(500).json({ error: 'Server error while looking up claim' });
+    }
+});
+
+// GET /api/claims/:claimId
+// One claim with its documents. Revalidation with If-None-Match answers 304 before the
+// document and storage lookups run.
+app.get('/api/claims/:claimId', async (req, res) => {
+    try {
+        const { claimId } = req.params;
+        const version = await checkClaimVersion(req, res, claimId);
+        if (!version) {
+            const archived = await fetchArchivedClaim(req, res, claimId);
+            if (!archived) {
+                return res.status(404).json({ error: 'Claim not found' });
+            }
+            return archived.notModified ? res.status(304).end() : res.json({ ...archived.claim, documents: archived.documents });
+        }
+        if (version.notModified) {
+            return res.status(304).end();
+        }
+
+        const [claimResult, documents] = await Promise.all([
+            pool.query(prepared(`SELECT ${CLAIM_ROW} FROM claims WHERE claim_id = $1`, [claimId])),
+            fetchClaimDocuments(claimId)
+        ]);
+        res.json({ ...claimResult.rows[0], documents });
+    } catch (error) {
+        req.log.error('Error processing GET /api/claims/:claimId', { error });
+        res.status(500).json({ error: 'Server error while fetching claim' });
+    }
+});
+
 // GET /api/claims/:claimId/documents
 app.get('/api/claims/:claimId/documents', async (req, res) => {
-    console.log('Received GET /api/claims/:claimId/documents at', new Date().toISOString());
-    console.log('Request headers:', req.headers);
-    console.log('Params:', req.params);
-
     try {
         const { claimId } = req.params;
-        const query = 'SELECT id, claim_id, file_name, file_path, uploaded_at FROM documents WHERE claim_id = $1';
-        console.log('Executing SQL SELECT for documents with claim_id:', claimId);
-        const result = await pool.query(query, [claimId]);
-        
-        // Verify files exist before returning them
-        const documentsWithExistence = await Promise.all(result.rows.map(async doc => {
-            const exists = fs.existsSync(doc.file_path);
-            return {
-                ...doc,
-                file_exists: exists,
-                url: exists ? `/uploads/${path.basename(doc.file_path)}` : null
-            };
-        }));
-        
-        console.log('Database select result with existence check:', documentsWithExistence);
+        // The HR modal's heavy read goes to the replica, version check included
+        const version = await checkClaimVersion(req, res, claimId, readPool);
+        if (version && version.notModified) {
+            return res.status(304).end();
+        }
+        if (!version) {
+            const archived = await fetchArchivedClaim(req, res, claimId);
+            if (archived) {
+                return archived.notModified ? res.status(304).end() : res.json(archived.documents);
+            }
+        }
+
+        const documentsWithExistence = await fetchClaimDocuments(claimId, readPool);
+        req.log.debug('Documents with existence check', { claimId, documents: documentsWithExistence });
         res.json(documentsWithExistence);
     } catch (error) {
-        console.error('Error processing GET /api/claims/:claimId/documents:', error.message, error.stack);
+        req.log.error('Error processing GET /api/claims/:claimId/documents', { error });
         res.status(500).json({ error: 'Server error while fetching documents' });
     }
 });
 
 // GET /api/documents/:documentId
 app.get('/api/documents/:documentId', async (req, res) => {
-    console.log('Received GET /api/documents/:documentId at', new Date().toISOString());
-    console.log('Params:', req.params);
-
     try {
         const { documentId } = req.params;
-        const query = 'SELECT file_path FROM documents WHERE id = $1';
-        const result = await pool.query(query, [documentId]);
-        
-        if (result.rows.length === 0) {
+        if (!/^\d+$/.test(documentId)) {
             return res.status(404).json({ error: 'Document not found' });
         }
+        // Archived documents keep their id
+        const query = `
+            SELECT id, file_name, file_path, content_hash FROM documents WHERE id = $1
+            UNION ALL
+            SELECT id, file_name, file_path, content_hash FROM documents_archive WHERE id = $1
+        `;
+        const result = await pool.query(prepared(query, [documentId]));
         
-        const filePath = result.rows[0].file_path;
-        if (!fs.existsSync(filePath)) {
-            return res.status(404).json({ error: 'File not found on server' });
+        if (result.rows.length === 0) {
+            return res.status(404).json({ error: 'Document not found' });
         }
         
-        res.sendFile(filePath);
+        const doc = result.rows[0];
+        await storage.forPath(doc.file_path).send(req, res, doc);
     } catch (error) {
-        console.error('Error processing GET /api/documents/:documentId:', error.message, error.stack);
+        req.log.error('Error processing GET /api/documents/:documentId', { error });
         res.status(500).json({ error: 'Server error while fetching document' });
     }
 });
 
+// GET /api/documents/:documentId/preview
+// WebP thumbnail (images) or first-page raster (PDFs). 202 while the worker hasn't
+// produced it yet, 404 when the document has no preview.
+app.get('/api/documents/:documentId/preview', async (req, res) => {
+    try {
+        const { documentId } = req.params;
+        if (!/^\d+$/.test(documentId)) {
+            return res.status(404).json({ error: 'Document not found' });
+        }
+        const result = await pool.query(prepared(
+            'SELECT status, file_path FROM document_previews WHERE document_id = $1',
+            [documentId]
+        ));
+        const preview = result.rows[0];
+        if (preview && preview.status === 'pending') {
+            res.set('Retry-After', '5');
+            return res.status(202).json({ status: 'pending' });
+        }
+        if (!preview || preview.status !== 'ready') {
+            return res.status(404).json({ error: 'Preview not available' });
+        }
+
+        // Previews are named by content hash and never rewritten
+        res.set('Cache-Control', `private, max-age=${IMMUTABLE_MAX_AGE / 1000}, immutable`);
+        res.sendFile(preview.file_path, error => {
+            if (error && !res.headersSent) {
+                res.status(error.statusCode === 404 ? 404 : 500).json({ error: 'Preview not available' });
+            }
+        });
+    } catch (error) {
+        req.log.error('Error processing GET /api/documents/:documentId/preview', { error });
+        res.status(500).json({ error: 'Server error while fetching preview' });
+    }
+});
+
+// PATCH /api/claims
+// Applies one decision to many claims: { claimIds: [...], status }. All rows change in a
+// single UPDATE; results report each requested ID as updated or not found. The claims are
+// locked in claim_id order first, so overlapping batches wait on each other instead of
+// deadlocking; a deadlock elsewhere (e.g. with a single-claim PATCH) is retried.
+app.patch('/api/claims', async (req, res) => {
+    req.log.debug('PATCH /api/claims payload', { body: req.body });
+
+    try {
+        const { claimIds, status } = req.body || {};
+
+        if (!['approved', 'rejected'].includes(status)) {
+            req.log.info('Validation failed', { reason: 'Invalid status' });
+            return res.status(400).json({ error: 'Status must be approved or rejected' });
+        }
+        if (!Array.isArray(claimIds) || claimIds.length === 0 || claimIds.length > MAX_BULK_CLAIMS
+            || claimIds.some(id => typeof id !== 'string' || !id)) {
+            req.log.info('Validation failed', { reason: 'Invalid claimIds' });
+            return res.status(400).json({ error: `claimIds must be a list of 1 to ${MAX_BULK_CLAIMS} claim IDs` });
+        }
+
+        const ids = [...new Set(claimIds)];
+        const query = `UPDATE claims SET status = $1, updated_at = $2 WHERE claim_id = ANY($3) RETURNING ${CLAIM_ROW}`;
+        const values = [status, new Date(), ids];
+        req.log.debug('Executing SQL UPDATE', { values });
+        const rows = await withTransaction(async client => {
+            await client.query(prepared(
+                'SELECT claim_id FROM claims WHERE claim_id = ANY($1) ORDER BY claim_id FOR UPDATE',
+                [ids]
+            ));
+            return (await client.query(prepared(query, values))).rows;
+        }, { deadlockRetries: BULK_DEADLOCK_RETRIES });
+
+        const updated = new Map(rows.map(row => [row.claim_id, row]));
+        const results = ids.map(claimId => updated.has(claimId)
+            ? { claimId, updated: true, claim: updated.get(claimId) }
+            : { claimId, updated: false, error: 'Claim not found' });
+
+        req.log.info('Claim statuses updated', { status, requested: ids.length, updated: rows.length });
+        res.json({ status, updated: rows.length, results });
+    } catch (error) {
+        req.log.error('Error processing PATCH /api/claims', { error });
+        res.status(500).json({ error: 'Server error while updating claims' });
+    }
+});
+
 // PATCH /api/claims/:claimId
 app.patch('/api/claims/:claimId', async (req, res) => {
-    console.log('Received PATCH /api/claims/:claimId at', new Date().toISOString());
-    console.log('Request headers:', req.headers);
-    console.log('Params:', req.params);
-    console.log('Request body:', req.body);
+    req.log.debug('PATCH /api/claims/:claimId payload', { params: req.params, body: req.body });
 
     try {
         const { claimId } = req.params;
         const { status } = req.body;
 
         if (!['approved', 'rejected'].includes(status)) {
-            console.log('Validation failed: Invalid status');
+            req.log.info('Validation failed', { reason: 'Invalid status' });
             return res.status(400).json({ error: 'Status must be approved or rejected' });
         }
 
-        const query = 'UPDATE claims SET status = $1, updated_at = $2 WHERE claim_id = $3 RETURNING *';
+        const query = `UPDATE claims SET status = $1, updated_at = $2 WHERE claim_id = $3 RETURNING ${CLAIM_ROW}`;
         const values = [status, new Date(), claimId];
-        console.log('Executing SQL UPDATE with values:', values);
-        const result = await pool.query(query, values);
+        req.log.debug('Executing SQL UPDATE', { values });
+        const result = await pool.query(prepared(query, values));
 
         if (result.rows.length === 0) {
-            console.log('No claim found for claim_id:', claimId);
+            req.log.info('No claim found', { claimId });
             return res.status(404).json({ error: 'Claim not found' });
         }
 
-        console.log('Claim status updated:', result.rows[0]);
+        req.log.info('Claim status updated', { claimId, status });
         res.json(result.rows[0]);
     } catch (error) {
-        console.error('Error processing PATCH /api/claims/:claimId:', error.message, error.stack);
+        req.log.error('Error processing PATCH /api/claims/:claimId', { error });
         res.status(500).json({ error: 'Server error while updating claim' });
     }
 });
@@ -386,7 +1344,7 @@ app.use(express.static(path.join(__dirname, 'Frontend')));
 
 // Error handling
 app.use((err, req, res, next) => {
-    console.error('Server error:', err.message, err.stack);
+    req.log.error('Server error', { error: err });
     if (err.message.includes('Only PDF, JPG, and PNG files are allowed')) {
         return res.status(400).json({ error: err.message });
     }
@@ -403,13 +1361,61 @@ app.use((err, req, res, next) => {
 const PORT = 3407;
 const HOST = '0.0.0.0'; // Listen on all interfaces
 
-app.listen(PORT, HOST, async () => {
-    console.log(`Server running on http://${HOST}:${PORT}`);
+const server = app.listen(PORT, HOST, async () => {
+    logger.info(`Server running on http://${HOST}:${PORT}`, { pid: process.pid });
     try {
         await initializeDatabase();
-        console.log('Database initialization complete');
+        logger.info('Database initialization complete');
+        await startReplicaMonitor();
+        await changeFeed.start();
+        if (RUNS_BACKGROUND_JOBS) {
+            uploadSessions.start();
+            archiver.start();
+        }
+        jobs.start();
+        previews.start()
+            .catch(error => logger.error('Preview worker failed to start', { error }));
+        ready = true;
     } catch (error) {
-        console.error('Failed to initialize database:', error);
+        logger.error('Failed to initialize database', { error });
         process.exit(1);
     }
 });
+
+// Graceful shutdown: stop accepting connections, let in-flight requests (uploads included)
+// finish, then stop background work and close the pool. Requests still running after
+// SHUTDOWN_TIMEOUT_MS have their connections closed.
+async function shutdown(signal) {
+    if (shuttingDown) return;
+    shuttingDown = true;
+    logger.info('Shutting down', { signal, pid: process.pid });
+
+    const forceClose = setTimeout(() => {
+        logger.warn('Requests still running after shutdown timeout; closing connections');
+        server.closeAllConnections();
+    }, SHUTDOWN_TIMEOUT_MS);
+    forceClose.unref();
+
+    try {
+        const closed = new Promise(resolve => server.close(resolve));
+        // SSE streams never finish on their own; EventSource reconnects to a live worker
+        changeFeed.disconnectAll();
+        server.closeIdleConnections();
+        await closed;
+        clearTimeout(forceClose);
+
+        uploadSessions.stop();
+        await archiver.stop();
+        await jobs.stop();
+        await changeFeed.stop();
+        await closePools();
+        logger.info('Shutdown complete', { pid: process.pid });
+        process.exit(0);
+    } catch (error) {
+        logger.error('Error during shutdown', { error });
+        process.exit(1);
+    }
+}
+
+process.on('SIGTERM', () => shutdown('SIGTERM'));
+process.on('SIGINT', () => shutdown('SIGINT'));
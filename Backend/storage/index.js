@@ -0,0 +1,41 @@
+const { LocalStorage } = require('./local');
+const { S3Storage } = require('./s3');
+
+// Storage backends resolve documents.file_path values to where the bytes live. Each one
+// implements owns(filePath), exists(filePath), publicUrl(doc), send(req, res, doc),
+// withLocalFile(filePath, fn), presignUploads(files) and removeUnreferenced(file). `primary` receives new uploads;
+// local storage always stays registered so documents written before a switch keep working.
+function createStorage({ uploadsDir }) {
+    const local = new LocalStorage({
+        directory: uploadsDir,
+        existsCacheTtlMs: Number(process.env.DOCUMENT_EXISTS_CACHE_TTL_MS) || 0
+    });
+    const backends = [local];
+    let primary = local;
+
+    if (process.env.STORAGE_BACKEND === 's3') {
+        primary = new S3Storage({
+            endpoint: process.env.S3_ENDPOINT || 'https://s3.amazonaws.com',
+            publicEndpoint: process.env.S3_PUBLIC_ENDPOINT,
+            region: process.env.S3_REGION || 'us-east-1',
+            bucket: process.env.S3_BUCKET,
+            accessKeyId: process.env.S3_ACCESS_KEY_ID,
+            secretAccessKey: process.env.S3_SECRET_ACCESS_KEY,
+            expiresIn: Number(process.env.S3_PRESIGN_EXPIRES) || 900
+        });
+        if (!primary.bucket || !primary.accessKeyId || !primary.secretAccessKey) {
+            throw new Error('STORAGE_BACKEND=s3 requires S3_BUCKET, S3_ACCESS_KEY_ID and S3_SECRET_ACCESS_KEY');
+        }
+        backends.unshift(primary);
+    }
+
+    return {
+        primary,
+        local,
+        forPath(filePath) {
+            return backends.find(backend => backend.owns(filePath)) || local;
+        }
+    };
+}
+
+module.exports = { createStorage };
@@ -0,0 +1,266 @@
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+const { Transform, pipeline } = require('stream');
+const { Counter, Histogram } = require('../metrics');
+const { withTransaction } = require('../db');
+
+const IMMUTABLE_MAX_AGE = 365 * 24 * 60 * 60 * 1000;
+
+// Shared with uploadSessions.js through the `source` label
+const uploadBytes = new Counter('document_upload_bytes_total', 'Document bytes received', ['source']);
+const uploadDuration = new Histogram('document_upload_duration_seconds', 'Time to receive and store one document (or one session chunk)', ['source', 'outcome']);
+const MAX_EXISTS_CACHE_ENTRIES = 10000;
+// Advisory lock space (two-key form) for stored content, keyed by a hash of the content hash
+const CONTENT_LOCK_NAMESPACE = 3408;
+
+// A stored file is shared by every document, upload session and archived document with its
+// content hash, but the database only learns about a new upload's reference when that
+// request commits. So removing a file takes the content lock exclusively, rechecks every
+// reference and unlinks while still holding it; a transaction about to reference stored
+// content takes the lock shared first (retain()) and puts the file back from its own copy if
+// a removal got there before it. `session` holds the lock past the transaction, until
+// unlockContent().
+function lockContent(client, contentHash, { exclusive = false, session = false } = {}) {
+    const fn = `pg_advisory${session ? '' : '_xact'}_lock${exclusive ? '' : '_shared'}`;
+    return client.query(`SELECT ${fn}($1, hashtext($2))`, [CONTENT_LOCK_NAMESPACE, contentHash]);
+}
+
+function unlockContent(client, contentHash) {
+    return client.query('SELECT pg_advisory_unlock($1, hashtext($2))', [CONTENT_LOCK_NAMESPACE, contentHash]);
+}
+
+// Moves a fully written temp file to <directory>/<hash><ext>. link() fails with EEXIST when
+// the content is already stored, so concurrent uploads of the same bytes never overwrite each
+// other. The temp file is removed, unless `keepTemp`: then it stays as the upload's own copy
+// until the reference to the content has committed (see lockContent).
+async function storeByHash(directory, tempPath, contentHash, ext, { keepTemp = false } = {}) {
+    const filename = contentHash + ext;
+    const finalPath = path.join(directory, filename);
+    let deduplicated = false;
+    try {
+        await fs.promises.link(tempPath, finalPath);
+    } catch (linkError) {
+        if (linkError.code !== 'EEXIST') {
+            await fs.promises.unlink(tempPath).catch(() => {});
+            throw linkError;
+        }
+        deduplicated = true;
+    }
+    if (!keepTemp) {
+        await fs.promises.unlink(tempPath).catch(() => {});
+    }
+    return { filename, path: finalPath, deduplicated };
+}
+
+// Multer storage engine that streams each upload through SHA-256 into a temp file and then
+// publishes it as <hash><ext>. Byte-identical uploads resolve to the same file, so a
+// duplicate costs no extra disk. The temp file (a hard link of the published one, or the
+// duplicate's bytes) is kept as file.tempPath until the request's claim has committed or
+// been rejected.
+class ContentAddressedStorage {
+    constructor({ directory, onStored = () => {}, onRemove = async () => {} }) {
+        this.directory = directory;
+        this.onStored = onStored;
+        this.onRemove = onRemove;
+        // Dot-prefixed so express.static never serves partial uploads
+        this.incomingDir = path.join(directory, '.incoming');
+        fs.mkdirSync(this.incomingDir, { recursive: true });
+    }
+
+    _handleFile(req, file, cb) {
+        const tempPath = path.join(this.incomingDir, crypto.randomUUID());
+        const hash = crypto.createHash('sha256');
+        const timer = uploadDuration.startTimer({ source: 'multipart' });
+        let size = 0;
+
+        const hasher = new Transform({
+            transform(chunk, encoding, callback) {
+                hash.update(chunk);
+                size += chunk.length;
+                callback(null, chunk);
+            }
+        });
+
+        pipeline(file.stream, hasher, fs.createWriteStream(tempPath), async error => {
+            uploadBytes.inc({ source: 'multipart' }, size);
+            timer({ outcome: error || file.stream.truncated ? 'failed' : 'stored' });
+            if (error) {
+                await fs.promises.unlink(tempPath).catch(() => {});
+                return cb(error);
+            }
+            // Multer rejects files that hit the size limit; leave them in .incoming for _removeFile
+            if (file.stream.truncated) {
+                return cb(null, { path: tempPath, size, temporary: true });
+            }
+
+            const contentHash = hash.digest('hex');
+            let stored;
+            try {
+                stored = await storeByHash(this.directory, tempPath, contentHash, path.extname(file.originalname).toLowerCase(), { keepTemp: true });
+            } catch (storeError) {
+                return cb(storeError);
+            }
+            this.onStored(stored.path);
+
+            cb(null, {
+                destination: this.directory,
+                filename: stored.filename,
+                path: stored.path,
+                tempPath,
+                size,
+                contentHash,
+                deduplicated: stored.deduplicated
+            });
+        });
+    }
+
+    // Called by multer for the files of a request it rejects. Only the temp copy is ours to
+    // delete; whether the published file can go is decided by onRemove under the content lock.
+    _removeFile(req, file, cb) {
+        if (file.temporary) {
+            fs.promises.unlink(file.path).then(() => cb(null), error => {
+                cb(error.code === 'ENOENT' ? null : error);
+            });
+            return;
+        }
+        this.onRemove(file).then(() => cb(null), cb);
+    }
+}
+
+// Documents stored on the backend's own disk; file_path holds the absolute path.
+// With existsCacheTtlMs > 0, existence checks are memoised per path so listing a claim's
+// documents doesn't stat every file; uploads and deletes through this process update the
+// cache, and the TTL bounds staleness from changes made elsewhere (other workers, operators).
+class LocalStorage {
+    constructor({ directory, existsCacheTtlMs = 0 }) {
+        this.name = 'local';
+        this.directory = directory;
+        this.existsCacheTtlMs = existsCacheTtlMs;
+        this.existsCache = existsCacheTtlMs > 0 ? new Map() : null;
+        this.multerEngine = new ContentAddressedStorage({
+            directory,
+            onStored: filePath => this.remember(filePath, true),
+            onRemove: async file => {
+                await this.releaseCopies([file]);
+                if (!file.deduplicated) await this.removeUnreferenced(file);
+            }
+        });
+    }
+
+    owns(filePath) {
+        return !filePath.includes('://');
+    }
+
+    remember(filePath, exists) {
+        if (!this.existsCache) return;
+        // Map keeps insertion order, so re-inserting makes this the newest entry
+        this.existsCache.delete(filePath);
+        this.existsCache.set(filePath, { exists, expiresAt: Date.now() + this.existsCacheTtlMs });
+        if (this.existsCache.size > MAX_EXISTS_CACHE_ENTRIES) {
+            this.existsCache.delete(this.existsCache.keys().next().value);
+        }
+    }
+
+    async exists(filePath) {
+        if (this.existsCache) {
+            const cached = this.existsCache.get(filePath);
+            if (cached && cached.expiresAt > Date.now()) return cached.exists;
+        }
+        let exists;
+        try {
+            await fs.promises.access(filePath);
+            exists = true;
+        } catch (error) {
+            exists = false;
+        }
+        this.remember(filePath, exists);
+        return exists;
+    }
+
+    publicUrl(doc) {
+        return `/uploads/${path.basename(doc.file_path)}`;
+    }
+
+    // Stored content never changes for a given document, so responses are cacheable forever.
+    // Content-addressed files get a strong ETag from their SHA-256; older ones keep send's
+    // weak size/mtime ETag. send handles HEAD, If-None-Match, Range and If-Range.
+    async send(req, res, doc) {
+        if (!(await this.exists(doc.file_path))) {
+            return res.status(404).json({ error: 'File not found on server' });
+        }
+        if (doc.content_hash) {
+            res.set('ETag', `"${doc.content_hash.trim()}"`);
+        }
+        res.set('Cache-Control', `private, max-age=${IMMUTABLE_MAX_AGE / 1000}, immutable`);
+        res.attachment(doc.file_name);
+        res.sendFile(doc.file_path, { acceptRanges: true });
+    }
+
+    // Documents are already on this disk; fn gets the path directly
+    async withLocalFile(filePath, fn) {
+        return fn(filePath);
+    }
+
+    // Browsers upload through POST /api/claims; there is nothing to presign
+    async presignUploads() {
+        return null;
+    }
+
+    // Inside the transaction that is about to reference stored content (`files` as
+    // { contentHash, filePath, tempPath }): takes the content locks shared and publishes the
+    // file again from its temp copy if a removal deleted it after the upload had stored it.
+    // Files without a temp copy (from upload sessions) must still be there.
+    async retain(client, files) {
+        for (const file of files) {
+            if (!file.contentHash || !this.owns(file.filePath)) continue;
+            await lockContent(client, file.contentHash);
+            try {
+                await fs.promises.access(file.filePath);
+            } catch (error) {
+                if (!file.tempPath) throw error;
+                await fs.promises.link(file.tempPath, file.filePath).catch(linkError => {
+                    if (linkError.code !== 'EEXIST') throw linkError;
+                });
+                this.remember(file.filePath, true);
+            }
+        }
+    }
+
+    // Drops the temp copies kept by uploads, once their references have committed or the
+    // request has been rejected
+    async releaseCopies(files) {
+        await Promise.all(files.filter(file => file.tempPath)
+            .map(file => fs.promises.unlink(file.tempPath).catch(() => {})));
+    }
+
+    // Deletes a stored file if no document, archived document or live upload session still
+    // references it, deciding and unlinking under the exclusive content lock. Archived
+    // documents are matched by path: until the archiver has moved it to cold storage, the
+    // hot file is theirs.
+    async removeUnreferenced(file) {
+        if (!file.contentHash) return false;
+        return withTransaction(async client => {
+            await lockContent(client, file.contentHash, { exclusive: true });
+            const result = await client.query(
+                `SELECT 1 FROM document_blobs WHERE content_hash = $1 AND ref_count > 0
+                 UNION ALL SELECT 1 FROM upload_sessions WHERE content_hash = $1
+                 UNION ALL SELECT 1 FROM documents_archive WHERE file_path = $2
+                 LIMIT 1`,
+                [file.contentHash, file.path]
+            );
+            if (result.rows.length > 0) return false;
+            try {
+                await fs.promises.unlink(file.path);
+            } catch (error) {
+                if (error.code !== 'ENOENT') throw error;
+            }
+            this.remember(file.path, false);
+            return true;
+        });
+    }
+}
+
+module.exports = {
+    ContentAddressedStorage, LocalStorage, storeByHash, lockContent, unlockContent, uploadBytes, uploadDuration, IMMUTABLE_MAX_AGE
+};
@@ -0,0 +1,186 @@
+const crypto = require('crypto');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { Readable } = require('stream');
+const { pipeline } = require('stream/promises');
+
+// RFC 3986 encoding as required by SigV4 canonical requests
+function uriEncode(value) {
+    return encodeURIComponent(value).replace(/[!'()*]/g, c => '%' + c.charCodeAt(0).toString(16).toUpperCase());
+}
+
+function hmac(key, data) {
+    return crypto.createHmac('sha256', key).update(data).digest();
+}
+
+function sha256Hex(data) {
+    return crypto.createHash('sha256').update(data).digest('hex');
+}
+
+// Documents in an S3-compatible bucket (AWS S3, MinIO, ...). file_path holds s3://<bucket>/<key>.
+// Browsers PUT and GET objects through presigned URLs, so document bytes never pass
+// through the backend process.
+class S3Storage {
+    constructor({ endpoint, publicEndpoint, region, bucket, accessKeyId, secretAccessKey, expiresIn }) {
+        this.name = 's3';
+        this.endpoint = endpoint;
+        // Host the browser uses; signatures cover the host, so it may differ from the internal one
+        this.publicEndpoint = publicEndpoint || endpoint;
+        this.region = region;
+        this.bucket = bucket;
+        this.accessKeyId = accessKeyId;
+        this.secretAccessKey = secretAccessKey;
+        this.expiresIn = expiresIn;
+        this.multerEngine = null;
+    }
+
+    owns(filePath) {
+        return filePath.startsWith(`s3://${this.bucket}/`);
+    }
+
+    keyFor(filePath) {
+        return filePath.slice(`s3://${this.bucket}/`.length);
+    }
+
+    locationFor(key) {
+        return `s3://${this.bucket}/${key}`;
+    }
+
+    // Query-string SigV4 presigning (path-style addressing)
+    presign(method, key, { endpoint = this.endpoint, headers = {}, query = {}, expiresIn = this.expiresIn } = {}) {
+        const url = new URL(endpoint);
+        const now = new Date();
+        const amzDate = now.toISOString().replace(/[-:]/g, '').replace(/\.\d{3}/, '');
+        const date = amzDate.slice(0, 8);
+        const scope = `${date}/${this.region}/s3/aws4_request`;
+        const canonicalUri = `/${this.bucket}/${key.split('/').map(uriEncode).join('/')}`;
+
+        const signedHeaders = { host: url.host };
+        for (const [name, value] of Object.entries(headers)) {
+            signedHeaders[name.toLowerCase()] = String(value).trim();
+        }
+        const headerNames = Object.keys(signedHeaders).sort();
+
+        const params = {
+            ...query,
+            'X-Amz-Algorithm': 'AWS4-HMAC-SHA256',
+            'X-Amz-Credential': `${this.accessKeyId}/${scope}`,
+            'X-Amz-Date': amzDate,
+            'X-Amz-Expires': String(expiresIn),
+            'X-Amz-SignedHeaders': headerNames.join(';')
+        };
+        const canonicalQuery = Object.keys(params).sort()
+            .map(name => `${uriEncode(name)}=${uriEncode(params[name])}`)
+            .join('&');
+
+        const canonicalRequest = [
+            method,
+            canonicalUri,
+            canonicalQuery,
+            headerNames.map(name => `${name}:${signedHeaders[name]}\n`).join(''),
+            headerNames.join(';'),
+            'UNSIGNED-PAYLOAD'
+        ].join('\n');
+        const stringToSign = ['AWS4-HMAC-SHA256', amzDate, scope, sha256Hex(canonicalRequest)].join('\n');
+
+        let signingKey = hmac('AWS4' + this.secretAccessKey, date);
+        signingKey = hmac(signingKey, this.region);
+        signingKey = hmac(signingKey, 's3');
+        signingKey = hmac(signingKey, 'aws4_request');
+        const signature = hmac(signingKey, stringToSign).toString('hex');
+
+        return `${url.origin}${canonicalUri}?${canonicalQuery}&X-Amz-Signature=${signature}`;
+    }
+
+    async head(key) {
+        const response = await fetch(this.presign('HEAD', key, { expiresIn: 60 }), { method: 'HEAD' });
+        if (response.status === 404) return null;
+        if (!response.ok) {
+            throw new Error(`S3 HEAD ${key} failed with status ${response.status}`);
+        }
+        return { size: Number(response.headers.get('content-length')) };
+    }
+
+    async exists(filePath) {
+        return (await this.head(this.keyFor(filePath))) !== null;
+    }
+
+    // Downloads the object to a temp file for tools that need a path (e.g. preview rendering)
+    async withLocalFile(filePath, fn) {
+        const key = this.keyFor(filePath);
+        const response = await fetch(this.presign('GET', key, { expiresIn: 60 }));
+        if (!response.ok) {
+            throw new Error(`S3 GET ${key} failed with status ${response.status}`);
+        }
+        const tempPath = path.join(os.tmpdir(), `s3-${crypto.randomUUID()}${path.extname(key)}`);
+        try {
+            await pipeline(Readable.fromWeb(response.body), fs.createWriteStream(tempPath));
+            return await fn(tempPath);
+        } finally {
+            await fs.promises.unlink(tempPath).catch(() => {});
+        }
+    }
+
+    publicUrl(doc) {
+        return `/api/documents/${doc.id}`;
+    }
+
+    async send(req, res, doc) {
+        // A URL presigned for GET is refused for HEAD, and following a redirect would need
+        // the bucket's CORS rules anyway; answer from the object's metadata instead
+        if (req.method === 'HEAD') {
+            const object = await this.head(this.keyFor(doc.file_path));
+            if (!object) {
+                return res.status(404).json({ error: 'File not found on server' });
+            }
+            res.set({ 'Cache-Control': 'no-store', 'Content-Length': object.size });
+            res.attachment(doc.file_name);
+            return res.status(200).end();
+        }
+        const url = this.presign('GET', this.keyFor(doc.file_path), {
+            endpoint: this.publicEndpoint,
+            query: { 'response-content-disposition': `attachment; filename="${doc.file_name.replace(/"/g, '')}"` }
+        });
+        // The presigned URL expires, so only the object behind it may be cached; S3 itself
+        // answers Range and If-None-Match requests
+        res.set('Cache-Control', 'no-store');
+        res.redirect(302, url);
+    }
+
+    // Returns one PUT target per file. When the browser supplies the SHA-256, the key is
+    // content-addressed, S3 verifies the checksum, and content already stored is skipped.
+    async presignUploads(files) {
+        return Promise.all(files.map(async file => {
+            const ext = path.extname(file.fileName).toLowerCase();
+            const contentAddressed = /^[0-9a-f]{64}$/.test(file.sha256 || '');
+            const key = contentAddressed ? `documents/${file.sha256}${ext}` : `documents/${crypto.randomUUID()}${ext}`;
+
+            if (contentAddressed && await this.head(key)) {
+                return { key, exists: true };
+            }
+
+            const headers = { 'Content-Type': file.contentType };
+            if (contentAddressed) {
+                headers['x-amz-checksum-sha256'] = Buffer.from(file.sha256, 'hex').toString('base64');
+            }
+            // Content-Length is signed too, so the declared (validated) size is enforced; browsers
+            // set it themselves and it is not returned as a header to send
+            const signedHeaders = { ...headers, 'Content-Length': file.size };
+            return {
+                key,
+                exists: false,
+                method: 'PUT',
+                url: this.presign('PUT', key, { endpoint: this.publicEndpoint, headers: signedHeaders }),
+                headers
+            };
+        }));
+    }
+
+    // Objects are content-addressed and may be shared; orphans are left for bucket lifecycle rules
+    async removeUnreferenced() {
+        return false;
+    }
+}
+
+module.exports = { S3Storage };
@@ -0,0 +1,279 @@
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+const { Transform } = require('stream');
+const { pipeline } = require('stream/promises');
+const { storeByHash, lockContent, uploadBytes, uploadDuration } = require('./storage/local');
+const { withTransaction } = require('./db');
+const { logger } = require('./logger');
+
+const SESSION_TTL_MS = 24 * 60 * 60 * 1000;
+const CLEANUP_INTERVAL_MS = 60 * 60 * 1000;
+// A lock older than this belongs to a request that died without releasing it
+const STALE_LOCK_MS = 5 * 60 * 1000;
+
+class UploadError extends Error {
+    constructor(status, message, offset) {
+        super(message);
+        this.status = status;
+        this.offset = offset;
+    }
+}
+
+// Resumable document uploads to local storage (offset-based, in the style of tus): the
+// browser creates a session, appends chunks with PATCH at the offset the server reports, and
+// after a dropped connection asks for the offset with HEAD and continues from there. Bytes
+// accumulate in .incoming/; when the last byte arrives the file is hashed and published
+// content-addressed like multipart uploads. A session whose declared SHA-256 is already
+// stored completes immediately without any bytes being sent.
+//
+// Sessions live in upload_sessions so every worker process sees them; the partial file
+// is the source of truth for the offset.
+class UploadSessions {
+    constructor({ pool, storage, allowedTypes, maxSize }) {
+        this.pool = pool;
+        this.storage = storage;
+        this.allowedTypes = allowedTypes;
+        this.maxSize = maxSize;
+        this.incomingDir = storage.multerEngine.incomingDir;
+        this.timer = null;
+    }
+
+    partPath(id) {
+        return path.join(this.incomingDir, `session-${id}`);
+    }
+
+    start() {
+        this.timer = setInterval(() => {
+            this.removeExpired().catch(error => logger.error('Upload session cleanup failed', { error }));
+        }, CLEANUP_INTERVAL_MS);
+        this.timer.unref();
+    }
+
+    stop() {
+        clearInterval(this.timer);
+        this.timer = null;
+    }
+
+    async create({ fileName, contentType, size, sha256 }) {
+        if (typeof fileName !== 'string' || !fileName || !this.allowedTypes.includes(contentType)) {
+            throw new UploadError(400, 'Only PDF, JPG, and PNG files are allowed');
+        }
+        if (!Number.isInteger(size) || size <= 0 || size > this.maxSize) {
+            throw new UploadError(400, 'File size exceeds 5MB limit');
+        }
+        const expectedHash = /^[0-9a-f]{64}$/.test(sha256 || '') ? sha256 : null;
+
+        const id = crypto.randomUUID();
+        const now = new Date();
+        // The existence check and the session row that references the file happen under the
+        // content lock, so a removal either sees the session or runs before the check
+        const completed = await withTransaction(async client => {
+            let existing = null;
+            if (expectedHash) {
+                await lockContent(client, expectedHash);
+                const existingPath = path.join(this.storage.directory, expectedHash + path.extname(fileName).toLowerCase());
+                const found = await fs.promises.access(existingPath).then(() => true, () => false);
+                if (found) {
+                    existing = { contentHash: expectedHash, filePath: existingPath };
+                }
+            }
+            await client.query(
+                `INSERT INTO upload_sessions (id, file_name, content_type, size_bytes, expected_hash, content_hash, file_path, completed_at, created_at, expires_at)
+                 VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10)`,
+                [id, fileName, contentType, size, expectedHash, existing && existing.contentHash,
+                    existing && existing.filePath, existing && now, now, new Date(now.getTime() + SESSION_TTL_MS)]
+            );
+            return existing;
+        });
+        return { id, size, offset: completed ? size : 0, complete: Boolean(completed) };
+    }
+
+    async get(id) {
+        if (!/^[0-9a-f-]{36}$/.test(id)) return null;
+        const result = await this.pool.query(
+            'SELECT * FROM upload_sessions WHERE id = $1 AND expires_at > $2',
+            [id, new Date()]
+        );
+        return result.rows[0] || null;
+    }
+
+    async offsetOf(session) {
+        if (session.completed_at) return Number(session.size_bytes);
+        const stat = await fs.promises.stat(this.partPath(session.id)).catch(() => null);
+        return stat ? stat.size : 0;
+    }
+
+    async status(id) {
+        const session = await this.get(id);
+        if (!session) throw new UploadError(404, 'Upload session not found');
+        return { size: Number(session.size_bytes), offset: await this.offsetOf(session), complete: Boolean(session.completed_at) };
+    }
+
+    // Appends the request body at `offset`. Bytes that arrive before a dropped connection are
+    // kept, so the next HEAD reports how far the upload got.
+    async append(id, offset, body) {
+        const session = await this.get(id);
+        if (!session) throw new UploadError(404, 'Upload session not found');
+        const size = Number(session.size_bytes);
+        if (session.completed_at) {
+            return { size, offset: size, complete: true };
+        }
+
+        const lockPath = `${this.partPath(id)}.lock`;
+        await this.lock(lockPath);
+        try {
+            const current = await this.offsetOf(session);
+            if (offset !== current) {
+                throw new UploadError(409, 'Upload-Offset does not match the bytes received', current);
+            }
+
+            let received = 0;
+            const timer = uploadDuration.startTimer({ source: 'session' });
+            const limiter = new Transform({
+                transform(chunk, encoding, callback) {
+                    received += chunk.length;
+                    uploadBytes.inc({ source: 'session' }, chunk.length);
+                    if (offset + received > size) {
+                        return callback(new UploadError(413, 'Upload exceeds the declared size'));
+                    }
+                    callback(null, chunk);
+                }
+            });
+            try {
+                await pipeline(body, limiter, fs.createWriteStream(this.partPath(id), { flags: 'a' }));
+                timer({ outcome: 'stored' });
+            } catch (error) {
+                timer({ outcome: 'failed' });
+                if (error instanceof UploadError) {
+                    // Drop the overflowing chunk entirely so the offset stays meaningful
+                    await fs.promises.truncate(this.partPath(id), current);
+                    throw error;
+                }
+                throw new UploadError(400, 'Upload interrupted', await this.offsetOf(session));
+            }
+
+            if (offset + received < size) {
+                return { size, offset: offset + received, complete: false };
+            }
+            await this.complete(session);
+            return { size, offset: size, complete: true };
+        } finally {
+            await fs.promises.unlink(lockPath).catch(() => {});
+        }
+    }
+
+    // O_EXCL lock file, so two workers can never append to the same part at once
+    async lock(lockPath) {
+        try {
+            await fs.promises.writeFile(lockPath, String(process.pid), { flag: 'wx' });
+        } catch (error) {
+            if (error.code !== 'EEXIST') throw error;
+            const stat = await fs.promises.stat(lockPath).catch(() => null);
+            if (stat && Date.now() - stat.mtimeMs < STALE_LOCK_MS) {
+                throw new UploadError(409, 'Another request is appending to this upload');
+            }
+            await fs.promises.unlink(lockPath).catch(() => {});
+            await fs.promises.writeFile(lockPath, String(process.pid), { flag: 'wx' });
+        }
+    }
+
+    async complete(session) {
+        const partPath = this.partPath(session.id);
+        const hash = crypto.createHash('sha256');
+        await pipeline(fs.createReadStream(partPath), async function* (source) {
+            for await (const chunk of source) hash.update(chunk);
+        });
+        const contentHash = hash.digest('hex');
+
+        if (session.expected_hash && session.expected_hash !== contentHash) {
+            await fs.promises.unlink(partPath).catch(() => {});
+            throw new UploadError(422, 'Uploaded bytes do not match the declared SHA-256; upload again', 0);
+        }
+
+        // The part file stays until the session row references the content (see lockContent)
+        const stored = await storeByHash(this.storage.directory, partPath, contentHash, path.extname(session.file_name).toLowerCase(), { keepTemp: true });
+        this.storage.remember(stored.path, true);
+        try {
+            await withTransaction(async client => {
+                await this.storage.retain(client, [{ contentHash, filePath: stored.path, tempPath: partPath }]);
+                await client.query(
+                    'UPDATE upload_sessions SET content_hash = $2, file_path = $3, completed_at = $4 WHERE id = $1',
+                    [session.id, contentHash, stored.path, new Date()]
+                );
+            });
+        } finally {
+            await fs.promises.unlink(partPath).catch(() => {});
+        }
+    }
+
+    // Completed sessions named in a claim submission, as document rows; error when any is unusable
+    async resolve(raw) {
+        let ids;
+        try {
+            ids = JSON.parse(raw);
+        } catch (error) {
+            return { error: 'uploadSessions must be a JSON array' };
+        }
+        if (!Array.isArray(ids) || ids.some(id => typeof id !== 'string' || !/^[0-9a-f-]{36}$/.test(id))) {
+            return { error: 'uploadSessions must be a JSON array of session IDs' };
+        }
+        const result = await this.pool.query(
+            `SELECT id, file_name, file_path, content_hash, size_bytes FROM upload_sessions
+             WHERE id = ANY($1::uuid[]) AND completed_at IS NOT NULL AND expires_at > $2`,
+            [ids, new Date()]
+        );
+        const byId = new Map(result.rows.map(row => [row.id, row]));
+        const missing = ids.filter(id => !byId.has(id));
+        if (missing.length > 0) {
+            return { error: `Uploads not complete or expired: ${missing.join(', ')}` };
+        }
+        return {
+            sessionIds: ids,
+            documents: ids.map(id => {
+                const row = byId.get(id);
+                return {
+                    fileName: row.file_name,
+                    filePath: row.file_path,
+                    contentHash: row.content_hash,
+                    size: Number(row.size_bytes)
+                };
+            })
+        };
+    }
+
+    // Deletes the sessions a claim takes its documents from, in the claim's transaction: a
+    // session is used once, and its row stays locked until the documents that now reference
+    // the content commit, so the expiry sweep can't remove the file in between. False when
+    // another claim or the sweep got to one of them first.
+    async consume(client, ids) {
+        const unique = [...new Set(ids)];
+        if (unique.length === 0) return true;
+        const result = await client.query(
+            'DELETE FROM upload_sessions WHERE id = ANY($1::uuid[]) AND completed_at IS NOT NULL AND expires_at > $2',
+            [unique, new Date()]
+        );
+        return result.rowCount === unique.length;
+    }
+
+    // Expired sessions: partial files are deleted; published content is kept if any document
+    // or live session still uses it
+    async removeExpired() {
+        const result = await this.pool.query(
+            'DELETE FROM upload_sessions WHERE expires_at <= $1 RETURNING id, content_hash, file_path, completed_at',
+            [new Date()]
+        );
+        for (const session of result.rows) {
+            if (!session.completed_at) {
+                await fs.promises.unlink(this.partPath(session.id)).catch(() => {});
+                continue;
+            }
+            await this.storage.removeUnreferenced({ contentHash: session.content_hash.trim(), path: session.file_path });
+        }
+        if (result.rows.length > 0) {
+            logger.info('Removed expired upload sessions', { count: result.rows.length });
+        }
+    }
+}
+
+module.exports = { UploadSessions, UploadError };
@@ -0,0 +1,283 @@
+const zlib = require('zlib');
+const { once } = require('events');
+
+// Minimal streaming .xlsx (Office Open XML) writer: one bold header row and typed cells per
+// sheet, inline strings so no shared-string table has to be held in memory. The zip is
+// written front to back; each entry's CRC and sizes follow its data in a data descriptor,
+// so nothing is buffered beyond one batch of rows. Entries and files stay below 4 GiB, as
+// there is no Zip64 support.
+
+// Excel refuses sheets longer than this; further rows continue on another sheet
+const MAX_SHEET_ROWS = 1048576;
+
+const LOCAL_FILE_HEADER = 0x04034b50;
+const DATA_DESCRIPTOR = 0x08074b50;
+const CENTRAL_DIRECTORY_HEADER = 0x02014b50;
+const END_OF_CENTRAL_DIRECTORY = 0x06054b50;
+// Bit 3: sizes and CRC in a data descriptor; bit 11: UTF-8 names
+const ZIP_FLAGS = 0x0808;
+const ZIP_VERSION = 20;
+const DEFLATE = 8;
+
+const CRC_TABLE = new Int32Array(256);
+for (let n = 0; n < 256; n++) {
+    let c = n;
+    for (let k = 0; k < 8; k++) {
+        c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+    }
+    CRC_TABLE[n] = c;
+}
+
+function crc32(buffer, previous = 0) {
+    let crc = ~previous;
+    for (let i = 0; i < buffer.length; i++) {
+        crc = CRC_TABLE[(crc ^ buffer[i]) & 0xff] ^ (crc >>> 8);
+    }
+    return ~crc >>> 0;
+}
+
+function dosDateTime(date) {
+    return {
+        time: (date.getHours() << 11) | (date.getMinutes() << 5) | (date.getSeconds() >> 1),
+        date: ((date.getFullYear() - 1980) << 9) | ((date.getMonth() + 1) << 5) | date.getDate()
+    };
+}
+
+class ZipWriter {
+    constructor() {
+        this.offset = 0;
+        this.entries = [];
+        this.stamp = dosDateTime(new Date());
+    }
+
+    track(buffer) {
+        this.offset += buffer.length;
+        return buffer;
+    }
+
+    begin(name) {
+        const entry = { name: Buffer.from(name), offset: this.offset, crc: 0, size: 0, compressedSize: 0 };
+        this.entries.push(entry);
+        const header = Buffer.alloc(30);
+        header.writeUInt32LE(LOCAL_FILE_HEADER, 0);
+        header.writeUInt16LE(ZIP_VERSION, 4);
+        header.writeUInt16LE(ZIP_FLAGS, 6);
+        header.writeUInt16LE(DEFLATE, 8);
+        header.writeUInt16LE(this.stamp.time, 10);
+        header.writeUInt16LE(this.stamp.date, 12);
+        // CRC and sizes (14-25) are left zero for the data descriptor
+        header.writeUInt16LE(entry.name.length, 26);
+        return { entry, header: this.track(Buffer.concat([header, entry.name])) };
+    }
+
+    descriptor(entry) {
+        const descriptor = Buffer.alloc(16);
+        descriptor.writeUInt32LE(DATA_DESCRIPTOR, 0);
+        descriptor.writeUInt32LE(entry.crc, 4);
+        descriptor.writeUInt32LE(entry.compressedSize, 8);
+        descriptor.writeUInt32LE(entry.size, 12);
+        return this.track(descriptor);
+    }
+
+    // A small entry in one piece
+    file(name, content) {
+        const data = Buffer.from(content);
+        const { entry, header } = this.begin(name);
+        const compressed = zlib.deflateRawSync(data);
+        entry.crc = crc32(data);
+        entry.size = data.length;
+        entry.compressedSize = compressed.length;
+        return Buffer.concat([header, this.track(compressed), this.descriptor(entry)]);
+    }
+
+    // An entry written in parts. write() returns the compressed bytes for what it was given,
+    // flushed so they can be sent right away; end() returns the rest and the descriptor.
+    stream(name) {
+        const { entry, header } = this.begin(name);
+        const deflate = zlib.createDeflateRaw();
+        const output = [];
+        deflate.on('data', chunk => output.push(chunk));
+        const take = () => {
+            const compressed = Buffer.concat(output);
+            output.length = 0;
+            entry.compressedSize += compressed.length;
+            return this.track(compressed);
+        };
+        return {
+            header,
+            write: async text => {
+                const data = Buffer.from(text);
+                entry.crc = crc32(data, entry.crc);
+                entry.size += data.length;
+                deflate.write(data);
+                await new Promise(resolve => deflate.flush(zlib.constants.Z_SYNC_FLUSH, resolve));
+                return take();
+            },
+            end: async () => {
+                deflate.end();
+                await once(deflate, 'end');
+                return Buffer.concat([take(), this.descriptor(entry)]);
+            }
+        };
+    }
+
+    // Central directory and end record, once every entry is complete
+    finish() {
+        const start = this.offset;
+        const headers = this.entries.map(entry => {
+            const header = Buffer.alloc(46);
+            header.writeUInt32LE(CENTRAL_DIRECTORY_HEADER, 0);
+            header.writeUInt16LE(ZIP_VERSION, 4);
+            header.writeUInt16LE(ZIP_VERSION, 6);
+            header.writeUInt16LE(ZIP_FLAGS, 8);
+            header.writeUInt16LE(DEFLATE, 10);
+            header.writeUInt16LE(this.stamp.time, 12);
+            header.writeUInt16LE(this.stamp.date, 14);
+            header.writeUInt32LE(entry.crc, 16);
+            header.writeUInt32LE(entry.compressedSize, 20);
+            header.writeUInt32LE(entry.size, 24);
+            header.writeUInt16LE(entry.name.length, 28);
+            header.writeUInt32LE(entry.offset, 42);
+            return Buffer.concat([header, entry.name]);
+        });
+        const directory = Buffer.concat(headers);
+        const end = Buffer.alloc(22);
+        end.writeUInt32LE(END_OF_CENTRAL_DIRECTORY, 0);
+        end.writeUInt16LE(this.entries.length, 8);
+        end.writeUInt16LE(this.entries.length, 10);
+        end.writeUInt32LE(directory.length, 12);
+        end.writeUInt32LE(start, 16);
+        return this.track(Buffer.concat([directory, end]));
+    }
+}
+
+const MAIN_NS = 'http://schemas.openxmlformats.org/spreadsheetml/2006/main';
+const REL_NS = 'http://schemas.openxmlformats.org/officeDocument/2006/relationships';
+const XML_DECLARATION = '<?xml version="1.0" encoding="UTF-8" standalone="yes"?>\n';
+
+// Cell styles, by index into cellXfs below
+const STYLE = { header: 1, date: 2, datetime: 3, amount: 4 };
+const STYLES_XML = `${XML_DECLARATION}<styleSheet xmlns="${MAIN_NS}">`
+    + '<numFmts count="2"><numFmt numFmtId="164" formatCode="yyyy-mm-dd"/><numFmt numFmtId="165" formatCode="yyyy-mm-dd hh:mm:ss"/></numFmts>'
+    + '<fonts count="2"><font><sz val="11"/><name val="Calibri"/></font><font><b/><sz val="11"/><name val="Calibri"/></font></fonts>'
+    + '<fills count="2"><fill><patternFill patternType="none"/></fill><fill><patternFill patternType="gray125"/></fill></fills>'
+    + '<borders count="1"><border><left/><right/><top/><bottom/><diagonal/></border></borders>'
+    + '<cellStyleXfs count="1"><xf numFmtId="0" fontId="0" fillId="0" borderId="0"/></cellStyleXfs>'
+    + '<cellXfs count="5">'
+    + '<xf numFmtId="0" fontId="0" fillId="0" borderId="0" xfId="0"/>'
+    + '<xf numFmtId="0" fontId="1" fillId="0" borderId="0" xfId="0" applyFont="1"/>'
+    + '<xf numFmtId="164" fontId="0" fillId="0" borderId="0" xfId="0" applyNumberFormat="1"/>'
+    + '<xf numFmtId="165" fontId="0" fillId="0" borderId="0" xfId="0" applyNumberFormat="1"/>'
+    + '<xf numFmtId="4" fontId="0" fillId="0" borderId="0" xfId="0" applyNumberFormat="1"/>'
+    + '</cellXfs>'
+    + '<cellStyles count="1"><cellStyle name="Normal" xfId="0" builtinId="0"/></cellStyles>'
+    + '</styleSheet>';
+
+// Strips characters XML 1.0 cannot carry at all, then escapes markup
+function escapeXml(value) {
+    return String(value)
+        .replace(/[\u0000-\u0008\u000b\u000c\u000e-\u001f\ufffe\uffff]/g, '')
+        .replace(/&/g, '&amp;')
+        .replace(/</g, '&lt;')
+        .replace(/>/g, '&gt;')
+        .replace(/"/g, '&quot;');
+}
+
+// Excel serial day number of a "YYYY-MM-DD[ HH:MM:SS]" wall-clock value (1900 date system)
+function serialDate(text) {
+    const match = /^(\d{4})-(\d{2})-(\d{2})(?:[ T](\d{2}):(\d{2}):(\d{2}))?/.exec(text);
+    if (!match) return null;
+    const [year, month, day, hours, minutes, seconds] = match.slice(1).map(part => Number(part || 0));
+    return Date.UTC(year, month - 1, day, hours, minutes, seconds) / 86400000 + 25569;
+}
+
+function cell(value, type) {
+    if (value === null || value === undefined || value === '') return '<c/>';
+    if (type === 'number' || type === 'amount') {
+        const number = Number(value);
+        if (Number.isFinite(number)) {
+            return type === 'amount' ? `<c s="${STYLE.amount}"><v>${number}</v></c>` : `<c><v>${number}</v></c>`;
+        }
+    } else if (type === 'date' || type === 'datetime') {
+        const serial = serialDate(String(value));
+        if (serial !== null) return `<c s="${STYLE[type]}"><v>${serial}</v></c>`;
+    }
+    return `<c t="inlineStr"><is><t xml:space="preserve">${escapeXml(value)}</t></is></c>`;
+}
+
+function sheetStart(columns) {
+    const widths = columns.map((column, i) => `<col min="${i + 1}" max="${i + 1}" width="${column.width || 14}" customWidth="1"/>`).join('');
+    const header = columns
+        .map(column => `<c t="inlineStr" s="${STYLE.header}"><is><t>${escapeXml(column.header)}</t></is></c>`)
+        .join('');
+    return `${XML_DECLARATION}<worksheet xmlns="${MAIN_NS}">`
+        + '<sheetViews><sheetView workbookViewId="0"><pane ySplit="1" topLeftCell="A2" activePane="bottomLeft" state="frozen"/></sheetView></sheetViews>'
+        + `<cols>${widths}</cols><sheetData><row>${header}</row>`;
+}
+
+const SHEET_END = '</sheetData></worksheet>';
+
+function packageParts(sheetNames) {
+    const sheets = sheetNames.map((name, i) => `<sheet name="${escapeXml(name)}" sheetId="${i + 1}" r:id="rId${i + 1}"/>`).join('');
+    const sheetRels = sheetNames
+        .map((_, i) => `<Relationship Id="rId${i + 1}" Type="${REL_NS}/worksheet" Target="worksheets/sheet${i + 1}.xml"/>`)
+        .join('');
+    const sheetTypes = sheetNames
+        .map((_, i) => `<Override PartName="/xl/worksheets/sheet${i + 1}.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml"/>`)
+        .join('');
+    return [
+        ['xl/workbook.xml', `${XML_DECLARATION}<workbook xmlns="${MAIN_NS}" xmlns:r="${REL_NS}"><sheets>${sheets}</sheets></workbook>`],
+        ['xl/_rels/workbook.xml.rels', `${XML_DECLARATION}<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">${sheetRels}`
+            + `<Relationship Id="rId${sheetNames.length + 1}" Type="${REL_NS}/styles" Target="styles.xml"/></Relationships>`],
+        ['xl/styles.xml', STYLES_XML],
+        ['_rels/.rels', `${XML_DECLARATION}<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">`
+            + `<Relationship Id="rId1" Type="${REL_NS}/officeDocument" Target="xl/workbook.xml"/></Relationships>`],
+        ['[Content_Types].xml', `${XML_DECLARATION}<Types xmlns="http://schemas.openxmlformats.org/package/2006/content-types">`
+            + '<Default Extension="rels" ContentType="application/vnd.openxmlformats-package.relationships+xml"/>'
+            + '<Default Extension="xml" ContentType="application/xml"/>'
+            + '<Override PartName="/xl/workbook.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml"/>'
+            + `${sheetTypes}<Override PartName="/xl/styles.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml"/></Types>`]
+    ];
+}
+
+// Yields the bytes of a workbook holding every row of `batches` (an async iterable of row
+// arrays). `columns` lists { key, header, type, width }, type being 'string', 'number',
+// 'amount', 'date' or 'datetime'; dates are "YYYY-MM-DD[ HH:MM:SS]" strings. The workbook
+// parts that name the sheets come last, once it is known how many there are.
+async function* xlsxChunks(columns, batches, { sheetName = 'Sheet' } = {}) {
+    const zip = new ZipWriter();
+    const sheetNames = [];
+    let sheet = null;
+    let sheetRows = 0;
+
+    const openSheet = async () => {
+        sheetNames.push(sheetNames.length === 0 ? sheetName : `${sheetName} (${sheetNames.length + 1})`);
+        sheet = zip.stream(`xl/worksheets/sheet${sheetNames.length}.xml`);
+        sheetRows = 1;
+        return Buffer.concat([sheet.header, await sheet.write(sheetStart(columns))]);
+    };
+
+    yield await openSheet();
+    for await (const rows of batches) {
+        let xml = '';
+        for (const row of rows) {
+            if (sheetRows === MAX_SHEET_ROWS) {
+                yield await sheet.write(xml + SHEET_END);
+                yield await sheet.end();
+                xml = '';
+                yield await openSheet();
+            }
+            xml += `<row>${columns.map(column => cell(row[column.key], column.type)).join('')}</row>`;
+            sheetRows++;
+        }
+        if (xml) yield await sheet.write(xml);
+    }
+    yield await sheet.write(SHEET_END);
+    yield await sheet.end();
+    for (const [name, content] of packageParts(sheetNames)) {
+        yield zip.file(name, content);
+    }
+    yield zip.finish();
+}
+
+module.exports = { xlsxChunks };
@@ -199,7 +199,8 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
             border-bottom: 1px solid var(--gray);
         }
 
-        .claims-table tr:nth-child(even) {
+        /* Only a window of rows is in the DOM, so stripes follow the claim index, not the child index */
+        .claims-table tr.row-alt {
             background-color: #f9f9f9;
         }
 
@@ -207,6 +208,37 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
             background-color: var(--light-blue);
         }
 
+        .table-viewport {
+            max-height: 70vh;
+            overflow-y: auto;
+            margin-top: 20px;
+            border-radius: 10px;
+        }
+
+        .table-viewport .claims-table {
+            margin-top: 0;
+        }
+
+        .table-viewport .claims-table th {
+            position: sticky;
+            top: 0;
+            z-index: 1;
+        }
+
+        /* Rows must keep one height for the scroll window arithmetic */
+        .claims-table td:last-child {
+            white-space: nowrap;
+        }
+
+        .claims-table tr.spacer-row td {
+            padding: 0;
+            border: none;
+        }
+
+        .claims-table tr.spacer-row:hover {
+            background-color: transparent;
+        }
+
         .no-claims {
             text-align: center;
             padding: 40px;
@@ -244,6 +276,101 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
             background: linear-gradient(135deg, var(--dark-red), #a93226);
         }
 
+        .btn:disabled {
+            opacity: 0.5;
+            cursor: not-allowed;
+        }
+
+        .bulk-actions {
+            display: flex;
+            align-items: center;
+            gap: 10px;
+            margin-top: 20px;
+        }
+
+        .bulk-actions .selection-count {
+            color: var(--dark-gray);
+            margin-right: auto;
+        }
+
+        .claims-table .select-cell {
+            width: 40px;
+        }
+
+        .doc-preview {
+            display: block;
+            max-width: 160px;
+            max-height: 160px;
+            margin: 6px 0 10px;
+            border-radius: 6px;
+            border: 1px solid var(--gray);
+            cursor: pointer;
+        }
+
+        .search-form {
+            display: flex;
+            flex-wrap: wrap;
+            align-items: flex-end;
+            gap: 10px;
+            margin-top: 20px;
+        }
+
+        .search-form label {
+            display: flex;
+            flex-direction: column;
+            font-size: 0.85rem;
+            color: var(--dark-gray);
+            gap: 4px;
+        }
+
+        .search-form input,
+        .search-form select {
+            padding: 8px 10px;
+            border: 1px solid var(--gray);
+            border-radius: 6px;
+            font-size: 0.95rem;
+        }
+
+        .search-form .search-query {
+            flex: 1;
+            min-width: 220px;
+        }
+
+        .search-summary {
+            margin-top: 15px;
+            color: var(--dark-gray);
+        }
+
+        .search-facets {
+            display: flex;
+            flex-wrap: wrap;
+            gap: 20px;
+            margin-top: 15px;
+        }
+
+        .search-facets h4 {
+            font-size: 0.95rem;
+            color: var(--dark-blue);
+            margin-bottom: 6px;
+        }
+
+        .facet-chip {
+            display: inline-block;
+            margin: 0 6px 6px 0;
+            padding: 4px 10px;
+            border: 1px solid var(--gray);
+            border-radius: 14px;
+            background: white;
+            font-size: 0.85rem;
+            cursor: pointer;
+        }
+
+        .facet-chip.active {
+            background: linear-gradient(135deg, var(--primary-blue), var(--purple));
+            color: white;
+            border-color: transparent;
+        }
+
         .btn-details {
             background: linear-gradient(135deg, var(--primary-blue), var(--purple));
             color: white;
@@ -574,6 +701,7 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
         <div class="nav-tabs">
             <div class="nav-tab active" onclick="showSection('action-required')">Action Required</div>
             <div class="nav-tab" onclick="showSection('action-completed')">Action Completed</div>
+            <div class="nav-tab" onclick="showSection('claim-search')">Search</div>
         </div>
 
         <div class="success-message" id="successMessage">
@@ -593,20 +721,32 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
                     <canvas id="pendingChart"></canvas>
                 </div>
             </div>
-            <table class="claims-table" id="pendingTable">
-                <thead>
-                    <tr>
-                        <th>Claim ID</th>
-                        <th>Type</th>
-                        <th>Employee ID</th>
-                        <th>Employee Name</th>
-                        <th>Amount</th>
-                        <th>Status</th>
-                        <th>Actions</th>
-                    </tr>
-                </thead>
-                <tbody></tbody>
-            </table>
+            <div class="bulk-actions">
+                <span class="selection-count" id="selectionCount">No claims selected</span>
+                <button class="btn btn-approve" id="bulkApprove" onclick="updateSelectedClaims('approved')" disabled>
+                    <i class="fas fa-check-double"></i> Approve Selected
+                </button>
+                <button class="btn btn-reject" id="bulkReject" onclick="updateSelectedClaims('rejected')" disabled>
+                    <i class="fas fa-times"></i> Reject Selected
+                </button>
+            </div>
+            <div class="table-viewport" id="pendingViewport">
+                <table class="claims-table" id="pendingTable">
+                    <thead>
+                        <tr>
+                            <th class="select-cell"><input type="checkbox" id="selectAllPending" title="Select all loaded claims" onchange="selectAllPending(this.checked)"></th>
+                            <th>Claim ID</th>
+                            <th>Type</th>
+                            <th>Employee ID</th>
+                            <th>Employee Name</th>
+                            <th>Amount</th>
+                            <th>Status</th>
+                            <th>Actions</th>
+                        </tr>
+                    </thead>
+                    <tbody></tbody>
+                </table>
+            </div>
             <div class="no-claims" id="noPendingClaims" style="display: none;">
                 <i class="fas fa-folder-open" style="font-size: 3rem; color: #ccc; margin-bottom: 15px;"></i>
                 <h3>No Pending Claims</h3>
@@ -625,20 +765,22 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
                     <canvas id="completedChart"></canvas>
                 </div>
             </div>
-            <table class="claims-table" id="completedTable">
-                <thead>
-                    <tr>
-                        <th>Claim ID</th>
-                        <th>Type</th>
-                        <th>Employee ID</th>
-                        <th>Employee Name</th>
-                        <th>Amount</th>
-                        <th>Status</th>
-                        <th>Actions</th>
-                    </tr>
-                </thead>
-                <tbody></tbody>
-            </table>
+            <div class="table-viewport" id="completedViewport">
+                <table class="claims-table" id="completedTable">
+                    <thead>
+                        <tr>
+                            <th>Claim ID</th>
+                            <th>Type</th>
+                            <th>Employee ID</th>
+                            <th>Employee Name</th>
+                            <th>Amount</th>
+                            <th>Status</th>
+                            <th>Actions</th>
+                        </tr>
+                    </thead>
+                    <tbody></tbody>
+                </table>
+            </div>
             <div class="no-claims" id="noCompletedClaims" style="display: none;">
                 <i class="fas fa-folder-open" style="font-size: 3rem; color: #ccc; margin-bottom: 15px;"></i>
                 <h3>No Completed Claims</h3>
@@ -646,6 +788,59 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
             </div>
         </section>
 
+        <section id="claim-search" class="section">
+            <h2 class="section-title">Search Claims</h2>
+            <form class="search-form" id="searchForm" onsubmit="event.preventDefault(); runSearch();">
+                <label class="search-query">Employee, description, department or type
+                    <input type="search" id="searchQuery" placeholder="e.g. ajay travel">
+                </label>
+                <label>Status
+                    <select id="searchStatus">
+                        <option value="">Any</option>
+                        <option value="pending">Pending</option>
+                        <option value="approved">Approved</option>
+                        <option value="rejected">Rejected</option>
+                    </select>
+                </label>
+                <label>Min amount (₹)
+                    <input type="number" id="searchAmountMin" min="0" step="0.01">
+                </label>
+                <label>Max amount (₹)
+                    <input type="number" id="searchAmountMax" min="0" step="0.01">
+                </label>
+                <label>Claim date from
+                    <input type="date" id="searchDateFrom">
+                </label>
+                <label>to
+                    <input type="date" id="searchDateTo">
+                </label>
+                <button type="submit" class="btn btn-details"><i class="fas fa-search"></i> Search</button>
+            </form>
+            <p class="search-summary" id="searchSummary"></p>
+            <div class="search-facets" id="searchFacets"></div>
+            <div class="table-viewport">
+                <table class="claims-table" id="searchTable">
+                    <thead>
+                        <tr>
+                            <th>Claim ID</th>
+                            <th>Type</th>
+                            <th>Employee ID</th>
+                            <th>Employee Name</th>
+                            <th>Amount</th>
+                            <th>Status</th>
+                            <th>Actions</th>
+                        </tr>
+                    </thead>
+                    <tbody></tbody>
+                </table>
+            </div>
+            <div class="bulk-actions">
+                <button class="btn btn-secondary" id="searchMore" onclick="loadMoreSearchResults()" style="display: none;">
+                    <i class="fas fa-angle-double-down"></i> Load more
+                </button>
+            </div>
+        </section>
+
         <div class="modal" id="detailsModal">
             <div class="modal-content">
                 <div class="modal-header">
@@ -665,8 +860,6 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
     </div>
 
     <script>
-        let pendingChartInstance = null;
-        let completedChartInstance = null;
         const CLAIM_TYPES = ['Medical', 'Travel', 'Education', 'Meal', 'Equipment', 'Other'];
         const TYPE_COLORS = {
             'Medical': 'rgba(0, 123, 255, 0.6)',
@@ -692,27 +885,62 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
             document.querySelector(`.nav-tab[onclick="showSection('${sectionId}')"]`).classList.add('active');
             document.getElementById('successMessage').classList.remove('show');
             document.getElementById(sectionId).scrollIntoView({ behavior: 'smooth' });
-            updateTables();
+            if (!tablesLoaded || !feedConnected) {
+                updateTables();
+            }
+            // The first visit shows every claim's facets before anything is typed
+            if (sectionId === 'claim-search' && searchState.params === null) {
+                runSearch();
+            }
+            // A table in a hidden section could not measure its rows or viewport
+            Object.values(TABLES).forEach(table => table.view.scheduleRender());
         }
 
         function closeModal(modalId) {
             document.getElementById(modalId).style.display = 'none';
+            if (modalId === 'detailsModal') {
+                openClaimId = null;
+            }
         }
 
-        function renderChart(canvasId, chartInstanceRef, labels, data, backgroundColors, borderColors) {
-            const ctx = document.getElementById(canvasId).getContext('2d');
-            if (chartInstanceRef) {
-                chartInstanceRef.destroy();
+        // One long-lived Chart per canvas. Later renders only swap the dataset values, and
+        // bursts of updates (e.g. from the change feed) collapse into one redraw per frame.
+        const charts = {};
+        const pendingChartData = new Map();
+        let chartFrame = null;
+
+        function flushChartUpdates() {
+            chartFrame = null;
+            pendingChartData.forEach((data, canvasId) => {
+                const chart = charts[canvasId];
+                chart.data.datasets[0].data = data;
+                chart.update('none');
+            });
+            pendingChartData.clear();
+        }
+
+        function renderChart(canvasId, data) {
+            if (!charts[canvasId]) {
+                charts[canvasId] = createChart(canvasId, data);
+                return;
+            }
+            pendingChartData.set(canvasId, data);
+            if (!chartFrame) {
+                chartFrame = requestAnimationFrame(flushChartUpdates);
             }
-            chartInstanceRef = new Chart(ctx, {
+        }
+
+        function createChart(canvasId, data) {
+            const ctx = document.getElementById(canvasId).getContext('2d');
+            return new Chart(ctx, {
                 type: 'bar',
                 data: {
-                    labels: labels,
+                    labels: CLAIM_TYPES,
                     datasets: [{
                         label: 'Claim Amount (₹)',
                         data: data,
-                        backgroundColor: backgroundColors,
-                        borderColor: borderColors,
+                        backgroundColor: CLAIM_TYPES.map(type => TYPE_COLORS[type]),
+                        borderColor: CLAIM_TYPES.map(type => TYPE_BORDER_COLORS[type]),
                         borderWidth: 1
                     }]
                 },
@@ -746,155 +974,466 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
                     }
                 }
             });
-            return chartInstanceRef;
         }
 
-        async function updateTables() {
-            try {
-                const response = await fetch('http://44.223.23.145:3407/api/claims');
-                const claims = await response.json();
-
-                const pendingTableBody = document.querySelector('#pendingTable tbody');
-                const completedTableBody = document.querySelector('#completedTable tbody');
-                const noPendingClaims = document.getElementById('noPendingClaims');
-                const noCompletedClaims = document.getElementById('noCompletedClaims');
-                const pendingTotals = document.getElementById('pendingTotals');
-                const completedTotals = document.getElementById('completedTotals');
-
-                pendingTableBody.innerHTML = '';
-                completedTableBody.innerHTML = '';
-
-                const pendingClaims = claims.filter(claim => claim.status === 'pending');
-                const completedClaims = claims.filter(claim => ['approved', 'rejected'].includes(claim.status));
-
-                // Pending Claims
-                const typeTotalsPending = CLAIM_TYPES.reduce((acc, type) => {
-                    acc[type] = 0;
-                    return acc;
-                }, {});
-                pendingClaims.forEach(claim => {
-                    if (CLAIM_TYPES.includes(claim.type)) {
-                        typeTotalsPending[claim.type] += Math.floor(claim.amount);
-                    } else {
-                        typeTotalsPending['Other'] += Math.floor(claim.amount);
-                    }
+        const API_BASE = 'http://44.223.23.145:3407';
+        const PAGE_SIZE = 50;
+        // Only what the table rows render; the details modal fetches the full claim
+        const TABLE_FIELDS = 'claim_id,type,employee_id,employee_name,amount,status,created_at';
+
+        // One keyset-paginated list per table; pages are fetched as the user scrolls
+        const tableState = {
+            pending: { status: 'pending', claims: [], cursor: null, done: false, loading: false, generation: 0 },
+            completed: { status: 'approved,rejected', claims: [], cursor: null, done: false, loading: false, generation: 0 }
+        };
+
+        async function fetchClaimsPage(state) {
+            const params = new URLSearchParams({ status: state.status, limit: PAGE_SIZE, fields: TABLE_FIELDS });
+            if (state.cursor) {
+                params.set('cursor', state.cursor);
+            }
+            const response = await fetch(`${API_BASE}/api/claims?${params}`);
+            if (!response.ok) {
+                const error = await response.json();
+                throw new Error(error.error || 'Failed to fetch claims');
+            }
+            const claims = await response.json();
+            state.cursor = response.headers.get('X-Next-Cursor');
+            state.done = !state.cursor;
+            return claims;
+        }
+
+        function emptyTypeTotals() {
+            return CLAIM_TYPES.reduce((acc, type) => {
+                acc[type] = 0;
+                return acc;
+            }, {});
+        }
+
+        // Totals come from GET /api/claims/summary, so the charts don't depend on which pages are loaded.
+        // The response's high-water mark is where a later delta sync can resume from.
+        async function fetchSummary() {
+            const response = await fetch(`${API_BASE}/api/claims/summary`);
+            if (!response.ok) {
+                const error = await response.json();
+                throw new Error(error.error || 'Failed to fetch claim summary');
+            }
+            const rows = await response.json();
+            const summary = { pending: emptyTypeTotals(), completed: emptyTypeTotals() };
+            rows.forEach(row => {
+                const totals = row.status === 'pending' ? summary.pending : summary.completed;
+                const type = CLAIM_TYPES.includes(row.type) ? row.type : 'Other';
+                totals[type] += Math.floor(row.total);
+            });
+            return { summary, highWaterMark: response.headers.get('X-High-Water-Mark') };
+        }
+
+        function buildPendingRow(claim) {
+            const row = document.createElement('tr');
+            row.dataset.claimId = claim.claim_id;
+            row.innerHTML = `
+                <td class="select-cell"><input type="checkbox" class="claim-select" ${selectedClaims.has(claim.claim_id) ? 'checked' : ''} onchange="toggleClaimSelection('${claim.claim_id}', this.checked)"></td>
+                <td>${claim.claim_id}</td>
+                <td>${claim.type}</td>
+                <td>${claim.employee_id}</td>
+                <td><span class="truncate" title="${claim.employee_name}">${claim.employee_name}</span></td>
+                <td>₹${Math.floor(claim.amount).toLocaleString('en-IN')}</td>
+                <td><span class="status status-${claim.status}">${claim.status.charAt(0).toUpperCase() + claim.status.slice(1)}</span></td>
+                <td>
+                    <button class="btn btn-approve" onclick="updateClaimStatus('${claim.claim_id}', 'approved')">
+                        <i class="fas fa-check"></i> Approve
+                    </button>
+                    <button class="btn btn-reject" onclick="updateClaimStatus('${claim.claim_id}', 'rejected')">
+                        <i class="fas fa-times"></i> Reject
+                    </button>
+                    <button class="btn btn-details" onclick="viewClaim('${claim.claim_id}')">
+                        <i class="fas fa-eye"></i> Details
+                    </button>
+                </td>
+            `;
+            return row;
+        }
+
+        function buildCompletedRow(claim) {
+            const row = document.createElement('tr');
+            row.dataset.claimId = claim.claim_id;
+            row.innerHTML = `
+                <td>${claim.claim_id}</td>
+                <td>${claim.type}</td>
+                <td>${claim.employee_id}</td>
+                <td><span class="truncate" title="${claim.employee_name}">${claim.employee_name}</span></td>
+                <td>₹${Math.floor(claim.amount).toLocaleString('en-IN')}</td>
+                <td><span class="status status-${claim.status}">${claim.status.charAt(0).toUpperCase() + claim.status.slice(1)}</span></td>
+                <td>
+                    <button class="btn btn-details" onclick="viewClaim('${claim.claim_id}')">
+                        <i class="fas fa-eye"></i> Details
+                    </button>
+                </td>
+            `;
+            return row;
+        }
+
+        function renderPendingSummary(typeTotalsPending) {
+            const totalPending = Object.values(typeTotalsPending).reduce((sum, amount) => sum + amount, 0);
+            document.getElementById('pendingTotals').innerHTML = `
+                <h3>Pending Claims Summary</h3>
+                <p><strong>Total Amount:</strong> ₹${totalPending.toLocaleString('en-IN')}</p>
+                ${CLAIM_TYPES.map(type => `<p><strong>${type}:</strong> ₹${typeTotalsPending[type].toLocaleString('en-IN')}</p>`).join('')}
+            `;
+            renderChart('pendingChart', CLAIM_TYPES.map(type => typeTotalsPending[type]));
+        }
+
+        function renderCompletedSummary(typeTotalsCompleted) {
+            const totalCompleted = Object.values(typeTotalsCompleted).reduce((sum, amount) => sum + amount, 0);
+            document.getElementById('completedTotals').innerHTML = `
+                <h3>Completed Claims Summary</h3>
+                <p><strong>Total Amount:</strong> ₹${totalCompleted.toLocaleString('en-IN')}</p>
+                ${CLAIM_TYPES.map(type => `<p><strong>${type}:</strong> ₹${typeTotalsCompleted[type].toLocaleString('en-IN')}</p>`).join('')}
+            `;
+            renderChart('completedChart', CLAIM_TYPES.map(type => typeTotalsCompleted[type]));
+        }
+
+        const DEFAULT_ROW_HEIGHT = 57;
+        const ROW_OVERSCAN = 10;
+
+        // Keeps only the rows inside a table's scroll viewport (plus an overscan margin) in the
+        // DOM; spacer rows stand in for the rest. Rows are keyed by claim_id and rebuilt only when
+        // the fields they display change, so a re-render mostly moves existing <tr> elements.
+        class VirtualTable {
+            constructor({ viewportId, tableId, buildRow, onNearEnd }) {
+                this.viewport = document.getElementById(viewportId);
+                this.tableBody = document.querySelector(`#${tableId} tbody`);
+                this.columnCount = document.querySelector(`#${tableId} thead tr`).cells.length;
+                this.buildRow = buildRow;
+                this.onNearEnd = onNearEnd;
+                this.claims = [];
+                this.rows = new Map();
+                this.rowHeight = 0;
+                this.frame = null;
+                this.topSpacer = this.createSpacer();
+                this.bottomSpacer = this.createSpacer();
+                this.viewport.addEventListener('scroll', () => this.scheduleRender(), { passive: true });
+                window.addEventListener('resize', () => {
+                    this.rowHeight = 0;
+                    this.scheduleRender();
                 });
+            }
 
-                if (pendingClaims.length === 0) {
-                    noPendingClaims.style.display = 'block';
-                    pendingTotals.innerHTML = `
-                        <h3>Pending Claims Summary</h3>
-                        <p><strong>Total Amount:</strong> ₹0</p>
-                        ${CLAIM_TYPES.map(type => `<p><strong>${type}:</strong> ₹0</p>`).join('')}
-                    `;
-                } else {
-                    noPendingClaims.style.display = 'none';
-                    const totalPending = Object.values(typeTotalsPending).reduce((sum, amount) => sum + amount, 0);
-                    pendingTotals.innerHTML = `
-                        <h3>Pending Claims Summary</h3>
-                        <p><strong>Total Amount:</strong> ₹${totalPending.toLocaleString('en-IN')}</p>
-                        ${CLAIM_TYPES.map(type => `<p><strong>${type}:</strong> ₹${typeTotalsPending[type].toLocaleString('en-IN')}</p>`).join('')}
-                    `;
-                    pendingClaims.forEach(claim => {
-                        const row = document.createElement('tr');
-                        row.innerHTML = `
-                            <td>${claim.claim_id}</td>
-                            <td>${claim.type}</td>
-                            <td>${claim.employee_id}</td>
-                            <td><span class="truncate" title="${claim.employee_name}">${claim.employee_name}</span></td>
-                            <td>₹${Math.floor(claim.amount).toLocaleString('en-IN')}</td>
-                            <td><span class="status status-${claim.status}">${claim.status.charAt(0).toUpperCase() + claim.status.slice(1)}</span></td>
-                            <td>
-                                <button class="btn btn-approve" onclick="updateClaimStatus('${claim.claim_id}', 'approved')">
-                                    <i class="fas fa-check"></i> Approve
-                                </button>
-                                <button class="btn btn-reject" onclick="updateClaimStatus('${claim.claim_id}', 'rejected')">
-                                    <i class="fas fa-times"></i> Reject
-                                </button>
-                                <button class="btn btn-details" onclick="viewClaim('${claim.claim_id}')">
-                                    <i class="fas fa-eye"></i> Details
-                                </button>
-                            </td>
-                        `;
-                        pendingTableBody.appendChild(row);
-                    });
+            createSpacer() {
+                const row = document.createElement('tr');
+                row.className = 'spacer-row';
+                const cell = document.createElement('td');
+                cell.colSpan = this.columnCount;
+                row.appendChild(cell);
+                return row;
+            }
+
+            setClaims(claims) {
+                this.claims = claims;
+                const ids = new Set(claims.map(claim => claim.claim_id));
+                for (const claimId of this.rows.keys()) {
+                    if (!ids.has(claimId)) this.rows.delete(claimId);
                 }
-                pendingChartInstance = renderChart(
-                    'pendingChart',
-                    pendingChartInstance,
-                    CLAIM_TYPES,
-                    CLAIM_TYPES.map(type => typeTotalsPending[type]),
-                    CLAIM_TYPES.map(type => TYPE_COLORS[type]),
-                    CLAIM_TYPES.map(type => TYPE_BORDER_COLORS[type])
-                );
-
-                // Completed Claims
-                const typeTotalsCompleted = CLAIM_TYPES.reduce((acc, type) => {
-                    acc[type] = 0;
-                    return acc;
-                }, {});
-                completedClaims.forEach(claim => {
-                    if (CLAIM_TYPES.includes(claim.type)) {
-                        typeTotalsCompleted[claim.type] += Math.floor(claim.amount);
+                this.scheduleRender();
+            }
+
+            scheduleRender() {
+                if (this.frame) return;
+                this.frame = requestAnimationFrame(() => {
+                    this.frame = null;
+                    this.render();
+                });
+            }
+
+            rowFor(claim) {
+                const signature = [claim.type, claim.employee_id, claim.employee_name, claim.amount, claim.status].join('|');
+                let entry = this.rows.get(claim.claim_id);
+                if (!entry || entry.signature !== signature) {
+                    entry = { signature, element: this.buildRow(claim) };
+                    this.rows.set(claim.claim_id, entry);
+                }
+                return entry.element;
+            }
+
+            render() {
+                const total = this.claims.length;
+                const rowHeight = this.rowHeight || DEFAULT_ROW_HEIGHT;
+                const scrollTop = this.viewport.scrollTop;
+                const viewportHeight = this.viewport.clientHeight || window.innerHeight;
+                const first = Math.max(0, Math.floor(scrollTop / rowHeight) - ROW_OVERSCAN);
+                const last = Math.min(total, Math.ceil((scrollTop + viewportHeight) / rowHeight) + ROW_OVERSCAN);
+                const visible = this.claims.slice(first, last).map(claim => this.rowFor(claim));
+
+                this.topSpacer.firstChild.style.height = `${first * rowHeight}px`;
+                this.bottomSpacer.firstChild.style.height = `${(total - last) * rowHeight}px`;
+                visible.forEach((row, offset) => row.classList.toggle('row-alt', (first + offset) % 2 === 1));
+
+                // Walk the desired order against the current children, moving only what is out of place
+                let cursor = this.tableBody.firstChild;
+                for (const row of [this.topSpacer, ...visible, this.bottomSpacer]) {
+                    if (row === cursor) {
+                        cursor = cursor.nextSibling;
                     } else {
-                        typeTotalsCompleted['Other'] += Math.floor(claim.amount);
+                        this.tableBody.insertBefore(row, cursor);
                     }
-                });
+                }
+                while (cursor) {
+                    const next = cursor.nextSibling;
+                    cursor.remove();
+                    cursor = next;
+                }
 
-                if (completedClaims.length === 0) {
-                    noCompletedClaims.style.display = 'block';
-                    completedTotals.innerHTML = `
-                        <h3>Completed Claims Summary</h3>
-                        <p><strong>Total Amount:</strong> ₹0</p>
-                        ${CLAIM_TYPES.map(type => `<p><strong>${type}:</strong> ₹0</p>`).join('')}
-                    `;
-                } else {
-                    noCompletedClaims.style.display = 'none';
-                    const totalCompleted = Object.values(typeTotalsCompleted).reduce((sum, amount) => sum + amount, 0);
-                    completedTotals.innerHTML = `
-                        <h3>Completed Claims Summary</h3>
-                        <p><strong>Total Amount:</strong> ₹${totalCompleted.toLocaleString('en-IN')}</p>
-                        ${CLAIM_TYPES.map(type => `<p><strong>${type}:</strong> ₹${typeTotalsCompleted[type].toLocaleString('en-IN')}</p>`).join('')}
-                    `;
-                    completedClaims.forEach(claim => {
-                        const row = document.createElement('tr');
-                        row.innerHTML = `
-                            <td>${claim.claim_id}</td>
-                            <td>${claim.type}</td>
-                            <td>${claim.employee_id}</td>
-                            <td><span class="truncate" title="${claim.employee_name}">${claim.employee_name}</span></td>
-                            <td>₹${Math.floor(claim.amount).toLocaleString('en-IN')}</td>
-                            <td><span class="status status-${claim.status}">${claim.status.charAt(0).toUpperCase() + claim.status.slice(1)}</span></td>
-                            <td>
-                                <button class="btn btn-details" onclick="viewClaim('${claim.claim_id}')">
-                                    <i class="fas fa-eye"></i> Details
-                                </button>
-                            </td>
-                        `;
-                        completedTableBody.appendChild(row);
-                    });
+                // Measure once the section is visible; hidden tables report zero height
+                if (!this.rowHeight && visible.length > 0 && visible[0].offsetHeight > 0) {
+                    this.rowHeight = visible[0].offsetHeight;
+                    if (this.rowHeight !== rowHeight) this.scheduleRender();
+                }
+                if (last >= total - ROW_OVERSCAN) {
+                    this.onNearEnd();
+                }
+            }
+        }
+
+        const TABLES = {
+            pending: { viewportId: 'pendingViewport', tableId: 'pendingTable', emptyId: 'noPendingClaims', buildRow: buildPendingRow },
+            completed: { viewportId: 'completedViewport', tableId: 'completedTable', emptyId: 'noCompletedClaims', buildRow: buildCompletedRow }
+        };
+
+        Object.entries(TABLES).forEach(([key, table]) => {
+            // Fetch the next page once the scroll window nears the last loaded row
+            table.view = new VirtualTable({
+                ...table,
+                onNearEnd: () => loadNextPage(key).catch(error => {
+                    console.error('Error fetching claims:', error);
+                })
+            });
+        });
+
+        function refreshTable(key) {
+            const state = tableState[key];
+            TABLES[key].view.setClaims(state.claims);
+            document.getElementById(TABLES[key].emptyId).style.display = tablesLoaded && state.claims.length === 0 ? 'block' : 'none';
+            if (key === 'pending') {
+                renderSelection();
+            }
+        }
+
+        // Pending claims ticked for a bulk decision. IDs that leave the pending table are ignored
+        // rather than dropped, since a change-feed update removes and re-inserts the row.
+        const selectedClaims = new Set();
+
+        function selectedPendingIds() {
+            return tableState.pending.claims.map(claim => claim.claim_id).filter(claimId => selectedClaims.has(claimId));
+        }
+
+        function renderSelection() {
+            const count = selectedPendingIds().length;
+            const loaded = tableState.pending.claims.length;
+            document.getElementById('selectionCount').textContent = count === 0 ? 'No claims selected' : `${count} claim${count === 1 ? '' : 's'} selected`;
+            document.getElementById('bulkApprove').disabled = count === 0;
+            document.getElementById('bulkReject').disabled = count === 0;
+            const selectAll = document.getElementById('selectAllPending');
+            selectAll.checked = loaded > 0 && count === loaded;
+            selectAll.indeterminate = count > 0 && count < loaded;
+        }
+
+        function syncRenderedCheckboxes() {
+            TABLES.pending.view.rows.forEach(({ element }, claimId) => {
+                element.querySelector('.claim-select').checked = selectedClaims.has(claimId);
+            });
+        }
+
+        function toggleClaimSelection(claimId, selected) {
+            if (selected) {
+                selectedClaims.add(claimId);
+            } else {
+                selectedClaims.delete(claimId);
+            }
+            renderSelection();
+        }
+
+        function selectAllPending(selected) {
+            selectedClaims.clear();
+            if (selected) {
+                tableState.pending.claims.forEach(claim => selectedClaims.add(claim.claim_id));
+            }
+            syncRenderedCheckboxes();
+            renderSelection();
+        }
+
+        async function loadNextPage(key) {
+            const state = tableState[key];
+            if (state.loading || state.done) return;
+            state.loading = true;
+            const generation = state.generation;
+            try {
+                const claims = await fetchClaimsPage(state);
+                // A refresh started while this page was in flight; drop the stale rows
+                if (generation !== state.generation) return;
+                state.claims.push(...claims);
+                rememberClaims(claims);
+                refreshTable(key);
+            } finally {
+                if (generation === state.generation) {
+                    state.loading = false;
                 }
-                completedChartInstance = renderChart(
-                    'completedChart',
-                    completedChartInstance,
-                    CLAIM_TYPES,
-                    CLAIM_TYPES.map(type => typeTotalsCompleted[type]),
-                    CLAIM_TYPES.map(type => TYPE_COLORS[type]),
-                    CLAIM_TYPES.map(type => TYPE_BORDER_COLORS[type])
-                );
+            }
+        }
+
+        let summaryState = null;
+        let tablesLoaded = false;
+        let changesSince = null;
+
+        function renderSummaries() {
+            renderPendingSummary(summaryState.pending);
+            renderCompletedSummary(summaryState.completed);
+        }
+
+        async function updateTables() {
+            try {
+                Object.entries(tableState).forEach(([key, state]) => {
+                    state.generation++;
+                    state.claims = [];
+                    state.cursor = null;
+                    state.done = false;
+                    state.loading = false;
+                    TABLES[key].view.setClaims(state.claims);
+                });
+                selectedClaims.clear();
+                const [{ summary, highWaterMark }] = await Promise.all([
+                    fetchSummary(),
+                    ...Object.keys(tableState).map(loadNextPage)
+                ]);
+                summaryState = summary;
+                changesSince = highWaterMark;
+                renderSummaries();
+                tablesLoaded = true;
+                Object.keys(tableState).forEach(refreshTable);
             } catch (error) {
                 console.error('Error fetching claims:', error);
                 alert('Error fetching claims: ' + error.message);
             }
         }
 
+        // Newest first, matching the server's ORDER BY created_at DESC, claim_id DESC
+        function compareClaims(a, b) {
+            const diff = new Date(b.created_at) - new Date(a.created_at);
+            if (diff !== 0) return diff;
+            return a.claim_id < b.claim_id ? 1 : a.claim_id > b.claim_id ? -1 : 0;
+        }
+
+        function removeClaimRow(key, claimId) {
+            const state = tableState[key];
+            const index = state.claims.findIndex(claim => claim.claim_id === claimId);
+            if (index === -1) return;
+            state.claims.splice(index, 1);
+            refreshTable(key);
+        }
+
+        function insertClaimRow(key, claim) {
+            const state = tableState[key];
+            let index = state.claims.findIndex(existing => compareClaims(claim, existing) < 0);
+            if (index === -1) {
+                // Sorts after every loaded row; if more pages remain, pagination will bring it in
+                if (!state.done) return;
+                index = state.claims.length;
+            }
+            state.claims.splice(index, 0, claim);
+            refreshTable(key);
+        }
+
+        function applySummaryDelta(key, claimType, amount) {
+            const type = CLAIM_TYPES.includes(claimType) ? claimType : 'Other';
+            summaryState[key][type] += amount;
+        }
+
+        // Patches rows and totals in place from one change-feed delta
+        function applyClaimChange({ op, claim, previous_status }) {
+            rememberClaims([claim]);
+            if (!tablesLoaded) return;
+            const key = claim.status === 'pending' ? 'pending' : 'completed';
+            const amount = Math.floor(claim.amount);
+            if (op === 'UPDATE' && previous_status) {
+                const previousKey = previous_status === 'pending' ? 'pending' : 'completed';
+                removeClaimRow(previousKey, claim.claim_id);
+                applySummaryDelta(previousKey, claim.type, -amount);
+            }
+            removeClaimRow(key, claim.claim_id);
+            insertClaimRow(key, claim);
+            applySummaryDelta(key, claim.type, amount);
+            renderSummaries();
+        }
+
+        // Catches up after a change-feed outage with GET /api/claims/changes, which returns only
+        // claims modified since the last sync instead of reloading every table
+        async function catchUpChanges() {
+            if (!tablesLoaded || !changesSince) {
+                return updateTables();
+            }
+            try {
+                let cursor = null;
+                let highWaterMark = changesSince;
+                do {
+                    const params = new URLSearchParams({ since: changesSince });
+                    if (cursor) {
+                        params.set('cursor', cursor);
+                    }
+                    const response = await fetch(`${API_BASE}/api/claims/changes?${params}`);
+                    if (!response.ok) {
+                        const error = await response.json();
+                        throw new Error(error.error || 'Failed to fetch claim changes');
+                    }
+                    const claims = await response.json();
+                    rememberClaims(claims);
+                    claims.forEach(claim => {
+                        removeClaimRow('pending', claim.claim_id);
+                        removeClaimRow('completed', claim.claim_id);
+                        insertClaimRow(claim.status === 'pending' ? 'pending' : 'completed', claim);
+                    });
+                    cursor = response.headers.get('X-Next-Cursor');
+                    highWaterMark = response.headers.get('X-High-Water-Mark');
+                } while (cursor);
+
+                // Deltas can't be applied to totals without each claim's previous state
+                const { summary } = await fetchSummary();
+                summaryState = summary;
+                renderSummaries();
+                changesSince = highWaterMark;
+            } catch (error) {
+                console.error('Error syncing claim changes:', error);
+                await updateTables();
+            }
+        }
+
+        let feedConnected = false;
+
+        // Server-Sent Events from /api/claims/events keep the tables current without refetching.
+        // Anything missed while disconnected is recovered with a delta sync on reconnect.
+        function connectChangeFeed() {
+            const source = new EventSource(`${API_BASE}/api/claims/events`);
+            let lostConnection = false;
+            source.addEventListener('open', () => {
+                feedConnected = true;
+                if (lostConnection) {
+                    lostConnection = false;
+                    catchUpChanges();
+                }
+            });
+            source.addEventListener('error', () => {
+                feedConnected = false;
+                lostConnection = true;
+            });
+            source.addEventListener('claim', event => applyClaimChange(JSON.parse(event.data)));
+            source.addEventListener('resync', () => catchUpChanges());
+        }
+
         async function updateClaimStatus(claimId, status) {
             const action = status.charAt(0).toUpperCase() + status.slice(1);
             const confirmed = window.confirm(`Are you sure you want to ${action.toLowerCase()} claim ${claimId}?`);
             if (!confirmed) return;
 
             try {
-                const response = await fetch(`http://44.223.23.145:3407/api/claims/${claimId}`, {
+                const response = await fetch(`${API_BASE}/api/claims/${claimId}`, {
                     method: 'PATCH',
                     headers: {
                         'Content-Type': 'application/json',
@@ -909,30 +1448,77 @@ background: linear-gradient(rgb(10, 10, 255),rgb(203, 11, 242));
 
                 document.getElementById('successMessage').classList.add('show');
                 document.getElementById('successMessage').scrollIntoView({ behavior: 'smooth' });
-                await updateTables();
+                // With the change feed up, the row moves when the server's delta arrives
+                if (!feedConnected) {
+                    await updateTables();
+                }
             } catch (error) {
                 console.error('Error updating claim:', error);
                 alert('Error updating claim: ' + error.message);
             }
         }
 
-        async function viewClaim(claimId) {
+        // One confirmation and one PATCH /api/claims for every selected pending claim
+        async function updateSelectedClaims(status) {
+            const claimIds = selectedPendingIds();
+            if (claimIds.length === 0) return;
+            const action = status === 'approved' ? 'approve' : 'reject';
+            const confirmed = window.confirm(`Are you sure you want to ${action} ${claimIds.length} claim${claimIds.length === 1 ? '' : 's'}?`);
+            if (!confirmed) return;
+
             try {
-                const [claimResponse, documentsResponse] = await Promise.all([
-                    fetch(`http://44.223.23.145:3407/api/claims?claim_id=${claimId}`),
-                    fetch(`http://44.223.23.145:3407/api/claims/${claimId}/documents`)
-                ]);
+                const response = await fetch(`${API_BASE}/api/claims`, {
+                    method: 'PATCH',
+                    headers: {
+                        'Content-Type': 'application/json',
+                    },
+                    body: JSON.stringify({ claimIds, status })
+                });
+                const result = await response.json();
+                if (!response.ok) {
+                    throw new Error(result.error || 'Failed to update claims');
+                }
 
-                const claims = await claimResponse.json();
-                const documents = await documentsResponse.json();
+                result.results.forEach(item => {
+                    if (item.updated) selectedClaims.delete(item.claimId);
+                });
+                syncRenderedCheckboxes();
+                renderSelection();
+                document.getElementById('successMessage').classList.add('show');
+                document.getElementById('successMessage').scrollIntoView({ behavior: 'smooth' });
 
-                const claim = claims[0];
-                if (!claim) {
-                    throw new Error('Claim not found');
+                const failed = result.results.filter(item => !item.updated);
+                if (failed.length > 0) {
+                    alert(`${failed.length} claim${failed.length === 1 ? ' was' : 's were'} not updated: ${failed.map(item => `${item.claimId} (${item.error})`).join(', ')}`);
+                }
+                // With the change feed up, rows move as the server's deltas arrive
+                if (!feedConnected) {
+                    await updateTables();
                 }
+            } catch (error) {
+                console.error('Error updating claims:', error);
+                alert('Error updating claims: ' + error.message);
+            }
+        }
+
+        // Claims already fetched for the tables (or by the change feed) keyed by claim_id, so the
+        // details modal opens from memory. documents stays null until the detail endpoint is read.
+        const claimStore = new Map();
+
+        function rememberClaims(claims) {
+            claims.forEach(claim => {
+                const entry = claimStore.get(claim.claim_id);
+                claimStore.set(claim.claim_id, {
+                    claim: entry ? { ...entry.claim, ...claim } : claim,
+                    documents: entry ? entry.documents : null
+                });
+            });
+        }
+
+        let openClaimId = null;
 
-                const detailsDiv = document.getElementById('claimDetails');
-detailsDiv.innerHTML = `
+        function renderClaimDetails(claim, documents) {
+            document.getElementById('claimDetails').innerHTML = `
     <div class="detail-row">
         <p class="detail-label">Claim ID: <span style="color: black;">${claim.claim_id}</span></p>
     </div>
@@ -969,20 +1555,44 @@ detailsDiv.innerHTML = `
     <div class="detail-row">
         <p class="detail-label">Documents:</p>
         <div style="margin-left: 15px; color: black;">
-            ${documents.length > 0 ? 
+            ${!documents ? '<p>Loading documents...</p>' : documents.length > 0 ? 
                 documents.map(doc => `
                     <p>
                         <a href="javascript:void(0)" onclick="downloadDocument('${doc.id}', '${doc.file_name}')">
                             <i class="fas fa-file-download"></i> ${doc.file_name}
                         </a>
+                        ${doc.preview_url ? `<img class="doc-preview" src="${API_BASE}${doc.preview_url}" alt="Preview of ${doc.file_name}" loading="lazy" onclick="downloadDocument('${doc.id}', '${doc.file_name}')">` : ''}
                     </p>
                 `).join('') : 
                 '<p>No documents uploaded</p>'}
         </div>
     </div>
 `;
+        }
 
+        async function viewClaim(claimId) {
+            try {
+                const cached = claimStore.get(claimId);
+                openClaimId = claimId;
+                // Table pages carry a column subset; render from memory once the full record is known
+                if (cached && cached.documents) {
+                    renderClaimDetails(cached.claim, cached.documents);
+                    document.getElementById('detailsModal').style.display = 'flex';
+                }
 
+                // no-cache makes the browser revalidate its copy with If-None-Match; an unchanged
+                // claim costs a 304 and the body is served from the HTTP cache
+                const response = await fetch(`${API_BASE}/api/claims/${encodeURIComponent(claimId)}`, { cache: 'no-cache' });
+                if (!response.ok) {
+                    throw new Error(response.status === 404 ? 'Claim not found' : 'Failed to fetch claim');
+                }
+                const { documents, ...claim } = await response.json();
+                claimStore.set(claimId, { claim, documents });
+
+                // Skip the repaint if the user has moved on or nothing changed
+                if (openClaimId !== claimId) return;
+                if (cached && cached.documents && JSON.stringify(cached) === JSON.stringify({ claim, documents })) return;
+                renderClaimDetails(claim, documents);
                 document.getElementById('detailsModal').style.display = 'flex';
             } catch (error) {
                 console.error('Error viewing claim:', error);
@@ -992,35 +1602,180 @@ detailsDiv.innerHTML = `
 
         async function downloadDocument(documentId, fileName) {
             try {
-                // First get the file path from the server
-                const response = await fetch(`http://44.223.23.145:3407/api/documents/${documentId}`);
-                
+                const url = `${API_BASE}/api/documents/${documentId}`;
+
+                // HEAD only confirms the file exists; the body crosses the wire once, via the anchor
+                const response = await fetch(url, { method: 'HEAD' });
                 if (!response.ok) {
-                    throw new Error('Failed to download document');
+                    throw new Error(response.status === 404 ? 'Document not found' : 'Failed to download document');
                 }
 
                 // Create a temporary anchor element to trigger the download
-                const url = `http://44.223.23.145:3407/api/documents/${documentId}`;
                 const a = document.createElement('a');
                 a.href = url;
                 a.download = fileName;
                 document.body.appendChild(a);
                 a.click();
                 document.body.removeChild(a);
-                
-                // Revoke the object URL to free up memory
-                setTimeout(() => {
-                    window.URL.revokeObjectURL(url);
-                }, 100);
             } catch (error) {
                 console.error('Error downloading document:', error);
                 alert('Error downloading document: ' + error.message);
             }
         }
 
+        // Server-side search (GET /api/claims/search). The form holds the text, status, amount
+        // and date filters; clicking a facet count narrows by that value, and clicking it again
+        // removes the filter. Type and department have no form field and are set by facets only.
+        const SEARCH_PAGE_SIZE = 50;
+        const SEARCH_INPUTS = {
+            q: 'searchQuery',
+            status: 'searchStatus',
+            amount_min: 'searchAmountMin',
+            amount_max: 'searchAmountMax',
+            date_from: 'searchDateFrom',
+            date_to: 'searchDateTo'
+        };
+        const FACET_TITLES = { status: 'Status', type: 'Type', department: 'Department', amount: 'Amount', month: 'Claim month' };
+        const searchState = { params: null, facetFilters: { type: null, department: null }, nextOffset: null, generation: 0 };
+
+        function searchParams() {
+            const params = new URLSearchParams({ limit: SEARCH_PAGE_SIZE, fields: TABLE_FIELDS });
+            Object.entries(SEARCH_INPUTS).forEach(([name, id]) => {
+                const value = document.getElementById(id).value.trim();
+                if (value) params.set(name, value);
+            });
+            Object.entries(searchState.facetFilters).forEach(([name, value]) => {
+                if (value !== null) params.set(name, value);
+            });
+            return params;
+        }
+
+        async function fetchSearchPage(params, offset) {
+            const pageParams = new URLSearchParams(params);
+            pageParams.set('offset', offset);
+            const response = await fetch(`${API_BASE}/api/claims/search?${pageParams}`);
+            if (!response.ok) {
+                const error = await response.json();
+                throw new Error(error.error || 'Failed to search claims');
+            }
+            return response.json();
+        }
+
+        async function runSearch() {
+            const generation = ++searchState.generation;
+            searchState.params = searchParams();
+            try {
+                const result = await fetchSearchPage(searchState.params, 0);
+                // A newer search was started while this one was in flight
+                if (generation !== searchState.generation) return;
+                document.querySelector('#searchTable tbody').replaceChildren();
+                appendSearchResults(result);
+                renderSearchFacets(result.facets);
+            } catch (error) {
+                console.error('Error searching claims:', error);
+                alert('Error searching claims: ' + error.message);
+            }
+        }
+
+        async function loadMoreSearchResults() {
+            if (searchState.nextOffset === null) return;
+            const generation = searchState.generation;
+            try {
+                const result = await fetchSearchPage(searchState.params, searchState.nextOffset);
+                if (generation !== searchState.generation) return;
+                appendSearchResults(result);
+            } catch (error) {
+                console.error('Error searching claims:', error);
+                alert('Error searching claims: ' + error.message);
+            }
+        }
+
+        function appendSearchResults(result) {
+            rememberClaims(result.claims);
+            const tableBody = document.querySelector('#searchTable tbody');
+            result.claims.forEach(claim => tableBody.appendChild(buildCompletedRow(claim)));
+            searchState.nextOffset = result.nextOffset;
+            document.getElementById('searchMore').style.display = result.nextOffset === null ? 'none' : 'inline-flex';
+            document.getElementById('searchSummary').textContent = result.total === 0
+                ? 'No claims match this search.'
+                : `${result.total.toLocaleString('en-IN')} matching claim${result.total === 1 ? '' : 's'}, showing ${tableBody.rows.length}`;
+        }
+
+        function monthRange(month) {
+            const [year, monthNumber] = month.split('-').map(Number);
+            // Day 0 of the next month is the last day of this one
+            return { from: `${month}-01`, to: new Date(Date.UTC(year, monthNumber, 0)).toISOString().slice(0, 10) };
+        }
+
+        // The form values (or facet filters) a facet entry stands for
+        function facetFilter(facet, entry) {
+            if (facet === 'amount') {
+                // Buckets include their lower bound only; amount_max is inclusive
+                return { amount_min: String(entry.min), amount_max: entry.max === null ? '' : (entry.max - 0.01).toFixed(2) };
+            }
+            if (facet === 'month') {
+                const { from, to } = monthRange(entry.value);
+                return { date_from: from, date_to: to };
+            }
+            return { [facet]: entry.value };
+        }
+
+        function currentFilterValue(name) {
+            if (name in searchState.facetFilters) return searchState.facetFilters[name] || '';
+            return document.getElementById(SEARCH_INPUTS[name]).value.trim();
+        }
+
+        function setFilterValue(name, value) {
+            if (name in searchState.facetFilters) {
+                searchState.facetFilters[name] = value || null;
+            } else {
+                document.getElementById(SEARCH_INPUTS[name]).value = value;
+            }
+        }
+
+        function facetLabel(facet, entry) {
+            if (facet === 'amount') {
+                const min = `₹${entry.min.toLocaleString('en-IN')}`;
+                return entry.max === null ? `${min}+` : `${min} – ₹${entry.max.toLocaleString('en-IN')}`;
+            }
+            if (facet === 'month') {
+                const [year, monthNumber] = entry.value.split('-').map(Number);
+                return new Date(year, monthNumber - 1, 1).toLocaleDateString('en-IN', { month: 'short', year: 'numeric' });
+            }
+            return facet === 'status' ? entry.value.charAt(0).toUpperCase() + entry.value.slice(1) : entry.value;
+        }
+
+        // Built with DOM calls, since facet values (departments, types) come from user input
+        function renderSearchFacets(facets) {
+            const container = document.getElementById('searchFacets');
+            container.replaceChildren();
+            Object.entries(FACET_TITLES).forEach(([facet, title]) => {
+                const entries = facets[facet].filter(entry => entry.value !== null && !(facet === 'amount' && entry.min === null));
+                if (entries.length === 0) return;
+                const group = document.createElement('div');
+                const heading = document.createElement('h4');
+                heading.textContent = title;
+                group.appendChild(heading);
+                entries.forEach(entry => {
+                    const filter = facetFilter(facet, entry);
+                    const active = Object.entries(filter).every(([name, value]) => currentFilterValue(name) === value);
+                    const chip = document.createElement('span');
+                    chip.className = `facet-chip${active ? ' active' : ''}`;
+                    chip.textContent = `${facetLabel(facet, entry)} (${entry.count.toLocaleString('en-IN')})`;
+                    chip.title = `₹${Math.floor(entry.total).toLocaleString('en-IN')} in total`;
+                    chip.addEventListener('click', () => {
+                        Object.entries(filter).forEach(([name, value]) => setFilterValue(name, active ? '' : value));
+                        runSearch();
+                    });
+                    group.appendChild(chip);
+                });
+                container.appendChild(group);
+            });
+        }
+
         document.addEventListener('DOMContentLoaded', function() {
+            connectChangeFeed();
             showSection('action-required');
-            updateTables();
         });
     </script>
 </body>
@@ -1,3 +1,6 @@
+-- Bootstrap schema for a fresh postgres volume. Later schema changes (indexes,
+-- rollups, ...) live in Backend/migrations and are applied by the backend at startup.
+
 -- Create the `claims` table
 CREATE TABLE claims (
     claim_id VARCHAR(20) PRIMARY KEY,
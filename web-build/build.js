@@ -0,0 +1,168 @@
+#!/usr/bin/env node
+// Static build for the employee portal and the HR dashboard.
+//
+//   node build.js <page.html> <outDir>
+//
+// Writes <outDir>/index.html plus <outDir>/assets/ with the page's inline CSS and JS
+// extracted, minified and named by content hash, so nginx can serve them with an
+// immutable one-year cache. Third-party CDN references are replaced by self-hosted copies:
+// Chart.js from the npm package, and Font Awesome by CSS mask icons for only the glyphs the
+// page uses. Every text file also gets .gz and .br siblings for nginx to serve as-is.
+
+const crypto = require('crypto');
+const fs = require('fs');
+const path = require('path');
+const zlib = require('zlib');
+const { minifyJs, minifyCss } = require('./minify');
+
+// CDN scripts and the package file that replaces each; the version is checked against the URL
+const VENDOR_SCRIPTS = [
+    {
+        url: /^https:\/\/cdn\.jsdelivr\.net\/npm\/chart\.js@([\d.]+)\/dist\/chart\.umd(?:\.min)?\.js$/,
+        packageName: 'chart.js',
+        files: ['dist/chart.umd.min.js', 'dist/chart.umd.js'],
+        assetName: 'chart'
+    }
+];
+const FONT_AWESOME_CSS = /^https:\/\/cdnjs\.cloudflare\.com\/ajax\/libs\/font-awesome\/([\d.]+)\/css\/all(?:\.min)?\.css$/;
+
+// Font Awesome 5 names still used in the markup, mapped to their Font Awesome 6 SVG files
+const ICON_ALIASES = {
+    'times': 'xmark',
+    'check-circle': 'circle-check',
+    'file-download': 'file-arrow-down',
+    'cloud-upload-alt': 'cloud-arrow-up',
+    'search': 'magnifying-glass',
+    'angle-double-down': 'angles-down'
+};
+
+function packageDir(name) {
+    return path.dirname(require.resolve(`${name}/package.json`, { paths: [__dirname] }));
+}
+
+function assertVersion(name, expected) {
+    const { version } = require(path.join(packageDir(name), 'package.json'));
+    if (version !== expected) {
+        throw new Error(`The page references ${name} ${expected} but ${version} is installed; update web-build/package.json`);
+    }
+}
+
+function contentHash(data) {
+    return crypto.createHash('sha256').update(data).digest('hex').slice(0, 12);
+}
+
+function iconCss(html, version) {
+    assertVersion('@fortawesome/fontawesome-free', version);
+    const svgDir = path.join(packageDir('@fortawesome/fontawesome-free'), 'svgs', 'solid');
+    const names = [...new Set([...html.matchAll(/\bfa-([a-z0-9-]+)/g)].map(match => match[1]))].sort();
+
+    const rules = names.map(name => {
+        const file = path.join(svgDir, `${ICON_ALIASES[name] || name}.svg`);
+        if (!fs.existsSync(file)) {
+            throw new Error(`Icon fa-${name} not found in Font Awesome ${version} (add it to ICON_ALIASES if it was renamed)`);
+        }
+        const svg = fs.readFileSync(file, 'utf8').replace(/<!--[\s\S]*?-->/g, '').trim();
+        const [, , width, height] = svg.match(/viewBox="([^"]+)"/)[1].split(/\s+/).map(Number);
+        const uri = svg.replace(/"/g, '\'').replace(/#/g, '%23').replace(/</g, '%3C').replace(/>/g, '%3E');
+        return `.fa-${name}{--fa-icon:url("data:image/svg+xml,${uri}");width:${(width / height).toFixed(4)}em}`;
+    });
+
+    return [
+        `/*! Icons: Font Awesome Free ${version} by @fontawesome - https://fontawesome.com License - https://fontawesome.com/license/free (Icons: CC BY 4.0) */`,
+        '.fas{display:inline-block;height:1em;vertical-align:-.125em;background-color:currentColor;'
+            + '-webkit-mask:var(--fa-icon) center/contain no-repeat;mask:var(--fa-icon) center/contain no-repeat}',
+        ...rules
+    ].join('\n') + '\n';
+}
+
+function vendorScript(vendor, version) {
+    assertVersion(vendor.packageName, version);
+    const dir = packageDir(vendor.packageName);
+    const file = vendor.files.map(name => path.join(dir, name)).find(candidate => fs.existsSync(candidate));
+    if (!file) {
+        throw new Error(`None of ${vendor.files.join(', ')} found in ${vendor.packageName}`);
+    }
+    // Source maps are not shipped
+    return fs.readFileSync(file, 'utf8').replace(/\n\/\/# sourceMappingURL=.*$/m, '') + '\n';
+}
+
+function build(pagePath, outDir) {
+    let html = fs.readFileSync(pagePath, 'utf8');
+    const assetsDir = path.join(outDir, 'assets');
+    fs.rmSync(outDir, { recursive: true, force: true });
+    fs.mkdirSync(assetsDir, { recursive: true });
+
+    const written = [];
+    function writeAsset(name, ext, data) {
+        const fileName = `${name}.${contentHash(data)}.${ext}`;
+        fs.writeFileSync(path.join(assetsDir, fileName), data);
+        written.push(path.join(assetsDir, fileName));
+        return `assets/${fileName}`;
+    }
+
+    let icons = '';
+    html = html.replace(/[ \t]*<link rel="stylesheet" href="([^"]+)">\n?/g, (tag, href) => {
+        const match = FONT_AWESOME_CSS.exec(href);
+        if (!match) {
+            throw new Error(`No self-hosted replacement for stylesheet ${href}`);
+        }
+        icons = iconCss(html, match[1]);
+        return '';
+    });
+
+    html = html.replace(/<script src="([^"]+)"><\/script>/g, (tag, src) => {
+        for (const vendor of VENDOR_SCRIPTS) {
+            const match = vendor.url.exec(src);
+            if (match) {
+                // Only used once the page has loaded data, so it never needs to block parsing
+                return `<script defer src="${writeAsset(vendor.assetName, 'js', vendorScript(vendor, match[1]))}"></script>`;
+            }
+        }
+        throw new Error(`No self-hosted replacement for script ${src}`);
+    });
+
+    html = html.replace(/<style>([\s\S]*?)<\/style>/, (tag, css) => {
+        return `<link rel="stylesheet" href="${writeAsset('app', 'css', minifyCss(css) + icons)}">`;
+    });
+
+    // Inline scripts keep their position, so code that expects the DOM above it still finds it
+    html = html.replace(/<script>([\s\S]*?)<\/script>/g, (tag, js) => {
+        return `<script src="${writeAsset('app', 'js', minifyJs(js))}"></script>`;
+    });
+
+    const indexPath = path.join(outDir, 'index.html');
+    fs.writeFileSync(indexPath, html);
+    written.push(indexPath);
+
+    for (const file of written) {
+        const data = fs.readFileSync(file);
+        fs.writeFileSync(`${file}.gz`, zlib.gzipSync(data, { level: zlib.constants.Z_BEST_COMPRESSION }));
+        fs.writeFileSync(`${file}.br`, zlib.brotliCompressSync(data, {
+            params: {
+                [zlib.constants.BROTLI_PARAM_QUALITY]: zlib.constants.BROTLI_MAX_QUALITY,
+                [zlib.constants.BROTLI_PARAM_SIZE_HINT]: data.length
+            }
+        }));
+    }
+    return written;
+}
+
+if (require.main === module) {
+    const [pagePath, outDir] = process.argv.slice(2);
+    if (!pagePath || !outDir) {
+        console.error('Usage: node build.js <page.html> <outDir>');
+        process.exit(1);
+    }
+    try {
+        for (const file of build(pagePath, outDir)) {
+            const size = fs.statSync(file).size;
+            const br = fs.statSync(`${file}.br`).size;
+            console.log(`${path.relative(outDir, file)}  ${size} bytes, ${br} brotli`);
+        }
+    } catch (error) {
+        console.error(`Build failed: ${error.message}`);
+        process.exit(1);
+    }
+}
+
+module.exports = { build };
@@ -0,0 +1,194 @@
+// Dependency-free minification for the pages' own CSS and JS. It only removes comments and
+// whitespace, which is where nearly all the savings in hand-written code are, and it keeps
+// line breaks in JS so automatic semicolon insertion behaves exactly as in the source.
+
+const IDENTIFIER = /[A-Za-z0-9_$\u0080-\uffff]/;
+// After these keywords a '/' starts a regular expression rather than a division
+const REGEX_KEYWORDS = new Set([
+    'return', 'typeof', 'instanceof', 'in', 'of', 'new', 'delete', 'void', 'throw',
+    'case', 'do', 'else', 'yield', 'await'
+]);
+
+function minifyJs(source) {
+    let out = '';
+    let pendingSpace = false;
+    let pendingNewline = false;
+    let lastToken = '';
+    // One frame per open template literal substitution: its brace depth
+    const templateStack = [];
+    let braceDepth = 0;
+    let i = 0;
+
+    function emit(text, token = text) {
+        if (pendingNewline && out && !out.endsWith('\n')) {
+            out += '\n';
+        } else if (pendingSpace && out) {
+            const prev = out[out.length - 1];
+            const next = text[0];
+            if ((IDENTIFIER.test(prev) && IDENTIFIER.test(next)) || (prev === next && (next === '+' || next === '-'))) {
+                out += ' ';
+            }
+        }
+        pendingSpace = false;
+        pendingNewline = false;
+        out += text;
+        lastToken = token;
+    }
+
+    function readQuoted(quote) {
+        let j = i + 1;
+        while (j < source.length && source[j] !== quote) {
+            if (source[j] === '\\') j++;
+            j++;
+        }
+        return source.slice(i, j + 1);
+    }
+
+    // Reads template text from start (an opening backtick or the '}' ending a substitution)
+    // up to and including the closing backtick or the next '${'
+    function readTemplateChunk(start) {
+        let j = start + 1;
+        while (j < source.length) {
+            if (source[j] === '\\') {
+                j += 2;
+            } else if (source[j] === '`') {
+                return { text: source.slice(start, j + 1), opensSubstitution: false };
+            } else if (source[j] === '$' && source[j + 1] === '{') {
+                return { text: source.slice(start, j + 2), opensSubstitution: true };
+            } else {
+                j++;
+            }
+        }
+        throw new Error('Unterminated template literal');
+    }
+
+    function readRegex() {
+        let j = i + 1;
+        let inClass = false;
+        while (j < source.length) {
+            const c = source[j];
+            if (c === '\\') {
+                j += 2;
+                continue;
+            }
+            if (c === '\n') throw new Error(`Unterminated regular expression at offset ${i}`);
+            if (c === '[') inClass = true;
+            else if (c === ']') inClass = false;
+            else if (c === '/' && !inClass) break;
+            j++;
+        }
+        j++;
+        while (j < source.length && /[a-z]/.test(source[j])) j++;
+        return source.slice(i, j);
+    }
+
+    function regexAllowed() {
+        if (!lastToken) return true;
+        if (REGEX_KEYWORDS.has(lastToken)) return true;
+        return !(IDENTIFIER.test(lastToken[lastToken.length - 1]) || lastToken === ')' || lastToken === ']' || lastToken === '}');
+    }
+
+    function emitTemplateChunk(start) {
+        const chunk = readTemplateChunk(start);
+        emit(chunk.text, '`');
+        i = start + chunk.text.length;
+        if (chunk.opensSubstitution) {
+            templateStack.push(braceDepth);
+            braceDepth = 0;
+            lastToken = '{';
+        }
+    }
+
+    while (i < source.length) {
+        const c = source[i];
+        const next = source[i + 1];
+
+        if (c === ' ' || c === '\t' || c === '\r') {
+            pendingSpace = true;
+            i++;
+        } else if (c === '\n') {
+            pendingNewline = true;
+            i++;
+        } else if (c === '/' && next === '/') {
+            while (i < source.length && source[i] !== '\n') i++;
+        } else if (c === '/' && next === '*') {
+            const end = source.indexOf('*/', i + 2);
+            if (end === -1) throw new Error('Unterminated block comment');
+            if (source.slice(i, end).includes('\n')) pendingNewline = true;
+            else pendingSpace = true;
+            i = end + 2;
+        } else if (c === '\'' || c === '"') {
+            const text = readQuoted(c);
+            emit(text, c);
+            i += text.length;
+        } else if (c === '`') {
+            emitTemplateChunk(i);
+        } else if (c === '/' && regexAllowed()) {
+            const text = readRegex();
+            emit(text, '/re/');
+            i += text.length;
+        } else if (c === '{') {
+            braceDepth++;
+            emit(c);
+            i++;
+        } else if (c === '}' && braceDepth === 0 && templateStack.length > 0) {
+            // Closes a ${...} substitution; the template text continues
+            braceDepth = templateStack.pop();
+            pendingSpace = false;
+            pendingNewline = false;
+            emitTemplateChunk(i);
+        } else if (c === '}') {
+            braceDepth--;
+            emit(c);
+            i++;
+        } else if (IDENTIFIER.test(c)) {
+            let j = i;
+            while (j < source.length && IDENTIFIER.test(source[j])) j++;
+            emit(source.slice(i, j));
+            i = j;
+        } else {
+            emit(c);
+            i++;
+        }
+    }
+    return out.trim() + '\n';
+}
+
+function minifyCss(source) {
+    let out = '';
+    let pendingSpace = false;
+    let i = 0;
+    while (i < source.length) {
+        const c = source[i];
+        if (c === '/' && source[i + 1] === '*') {
+            const end = source.indexOf('*/', i + 2);
+            if (end === -1) throw new Error('Unterminated CSS comment');
+            // Keep /*! license */ banners
+            if (source[i + 2] === '!') out += source.slice(i, end + 2);
+            i = end + 2;
+        } else if (/\s/.test(c)) {
+            pendingSpace = true;
+            i++;
+        } else if (c === '"' || c === '\'') {
+            let j = i + 1;
+            while (j < source.length && source[j] !== c) {
+                if (source[j] === '\\') j++;
+                j++;
+            }
+            if (pendingSpace && out && !/[{};,:(]$/.test(out)) out += ' ';
+            pendingSpace = false;
+            out += source.slice(i, j + 1);
+            i = j + 1;
+        } else {
+            // Spaces around punctuation that never needs them; combinators and calc() operators keep theirs
+            if (pendingSpace && out && !/[{};,:(]$/.test(out) && !'{};,)'.includes(c)) out += ' ';
+            pendingSpace = false;
+            if (c === '}' && out.endsWith(';')) out = out.slice(0, -1);
+            out += c;
+            i++;
+        }
+    }
+    return out.trim() + '\n';
+}
+
+module.exports = { minifyJs, minifyCss };